@@ -0,0 +1,214 @@
+#include "structs.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+const float default_hourly_rates[24] = {
+    5, 2, 1, 1, 2, 10, 25, 40, 80, 100, 120, 160,
+    220, 200, 140, 130, 170, 260, 280, 200, 130, 80, 40, 15
+};
+
+RateCurve arrival_curve;
+AliasTable cart_table;
+
+void build_alias_table(AliasTable* table, const float* weights, int size) {
+    table->size = size;
+    table->prob = (float*)malloc(sizeof(float) * size);
+    table->alias = (int*)malloc(sizeof(int) * size);
+
+    float* scaled = (float*)malloc(sizeof(float) * size);
+    int* small = (int*)malloc(sizeof(int) * size);
+    int* large = (int*)malloc(sizeof(int) * size);
+    int small_count = 0;
+    int large_count = 0;
+
+    double total = 0.0;
+    for (int i = 0; i < size; i++) total += weights[i] > 0 ? weights[i] : 0;
+    for (int i = 0; i < size; i++) {
+        float w = weights[i] > 0 ? weights[i] : 0;
+        scaled[i] = total > 0 ? (float)(w * size / total) : 1.0f;
+        table->alias[i] = i;
+        if (scaled[i] < 1.0f) small[small_count++] = i;
+        else large[large_count++] = i;
+    }
+
+    while (small_count > 0 && large_count > 0) {
+        int s = small[--small_count];
+        int l = large[--large_count];
+        table->prob[s] = scaled[s];
+        table->alias[s] = l;
+        scaled[l] = (scaled[l] + scaled[s]) - 1.0f;
+        if (scaled[l] < 1.0f) small[small_count++] = l;
+        else large[large_count++] = l;
+    }
+    while (large_count > 0) table->prob[large[--large_count]] = 1.0f;
+    while (small_count > 0) table->prob[small[--small_count]] = 1.0f;
+
+    free(scaled);
+    free(small);
+    free(large);
+}
+
+// Column and coin come from one 32-bit draw each; the select is branch-free so
+// the inner loop vectorizes.
+void sample_cart_sizes(AliasTable* table, RngStream* r, int* out, int n) {
+    uint32_t columns[ARRIVAL_BATCH];
+    uint32_t coins[ARRIVAL_BATCH];
+
+    for (int start = 0; start < n; start += ARRIVAL_BATCH) {
+        int count = n - start < ARRIVAL_BATCH ? n - start : ARRIVAL_BATCH;
+        for (int i = 0; i < count; i++) {
+            columns[i] = rng_next_u32(r);
+            coins[i] = rng_next_u32(r);
+        }
+        for (int i = 0; i < count; i++) {
+            int column = (int)(((uint64_t)columns[i] * (uint32_t)table->size) >> 32);
+            float coin = (coins[i] >> 8) * (1.0f / 16777216.0f);
+            out[start + i] = 1 + (coin < table->prob[column] ? column : table->alias[column]);
+        }
+    }
+}
+
+void init_rate_curve(RateCurve* curve) {
+    float rates[RATE_CURVE_MAX_SEGMENTS];
+    int count = 0;
+    if (arrival_rate_curve != NULL) {
+        count = parse_float_list(arrival_rate_curve, rates, RATE_CURVE_MAX_SEGMENTS);
+    }
+    if (count == 0) {
+        memcpy(rates, default_hourly_rates, sizeof(default_hourly_rates));
+        count = 24;
+    }
+
+    curve->segments = count;
+    curve->segment_seconds = 86400.0 / count;
+    curve->offset_seconds = day_start_hour * 3600.0;
+    for (int i = 0; i < count; i++) {
+        curve->rates[i] = rates[i] > 0 ? rates[i] * arrival_rate_scale / 3600.0 : 0.0;
+    }
+}
+
+void init_arrival_model() {
+    init_rate_curve(&arrival_curve);
+
+    float weights[MAX_CART_ITEMS];
+    int size = 15;
+    if (strcmp(cart_distribution, "lognormal") == 0) {
+        size = max_cart_items < MAX_CART_ITEMS ? max_cart_items : MAX_CART_ITEMS;
+        for (int k = 1; k <= size; k++) {
+            double lo = log(k - 0.5 > 0.01 ? k - 0.5 : 0.01);
+            double hi = log(k + 0.5);
+            weights[k - 1] = (float)(0.5 * (erf((hi - cart_log_mean) / (cart_log_sigma * sqrt(2.0))) -
+                                            erf((lo - cart_log_mean) / (cart_log_sigma * sqrt(2.0)))));
+        }
+    } else if (strcmp(cart_distribution, "empirical") == 0 && cart_weights != NULL) {
+        size = parse_float_list(cart_weights, weights, MAX_CART_ITEMS);
+        if (size == 0) {
+            size = 15;
+            for (int k = 0; k < size; k++) weights[k] = 1.0f;
+        }
+    } else {
+        for (int k = 0; k < size; k++) weights[k] = 1.0f;
+    }
+    build_alias_table(&cart_table, weights, size);
+}
+
+bool uniform_arrivals() {
+    return strcmp(arrival_mode, "nhpp") != 0;
+}
+
+bool uniform_carts() {
+    return strcmp(cart_distribution, "lognormal") != 0 && strcmp(cart_distribution, "empirical") != 0;
+}
+
+void fill_cart_sizes(RngStream* r, int* out, int n) {
+    if (uniform_carts()) {
+        rng_fill_range(r, out, n, 1, 15);
+    } else {
+        sample_cart_sizes(&cart_table, r, out, n);
+    }
+}
+
+// Exact non-homogeneous Poisson arrivals for a piecewise-constant rate curve:
+// draw unit exponentials in a batch, then walk the cumulative intensity. The
+// current segment and the intensity left in it carry over between arrivals,
+// so the day position is only worked out once per call.
+int generate_arrival_times(RateCurve* curve, RngStream* r, double* clock, double horizon, double* out, int max) {
+    float exponentials[ARRIVAL_BATCH];
+    int produced = 0;
+
+    double t = *clock;
+    double day_time = fmod(t + curve->offset_seconds, 86400.0);
+    int segment = (int)(day_time / curve->segment_seconds);
+    if (segment >= curve->segments) segment = curve->segments - 1;
+    double segment_end = t + (segment + 1) * curve->segment_seconds - day_time;
+    double rate = curve->rates[segment];
+    double left = rate * (segment_end - t);
+
+    while (produced < max) {
+        int count = max - produced < ARRIVAL_BATCH ? max - produced : ARRIVAL_BATCH;
+        for (int i = 0; i < count; i++) {
+            exponentials[i] = (float)((rng_next_u32(r) >> 8) + 1) * (1.0f / 16777217.0f);
+        }
+        for (int i = 0; i < count; i++) {
+            exponentials[i] = -logf(exponentials[i]);
+        }
+
+        for (int i = 0; i < count; i++) {
+            double remaining = exponentials[i];
+            int guard = 0;
+            while (remaining > left) {
+                remaining -= left;
+                t = segment_end;
+                if (t >= horizon || ++guard > curve->segments * 2) {
+                    *clock = horizon;
+                    return produced;
+                }
+                if (++segment == curve->segments) segment = 0;
+                segment_end = t + curve->segment_seconds;
+                rate = curve->rates[segment];
+                left = rate * curve->segment_seconds;
+            }
+            t += remaining / rate;
+            left -= remaining;
+            if (t >= horizon) {
+                *clock = horizon;
+                return produced;
+            }
+            out[produced++] = t;
+        }
+    }
+    *clock = t;
+    return produced;
+}
+
+void benchmark_arrivals(int stores) {
+    double* times = (double*)malloc(sizeof(double) * ARRIVAL_BATCH);
+    int* carts = (int*)malloc(sizeof(int) * ARRIVAL_BATCH);
+    long long total = 0;
+    long long items = 0;
+
+    double start = wall_seconds();
+    for (int store = 0; store < stores; store++) {
+        RngStream arrivals;
+        RngStream customers;
+        rng_seed(&arrivals, simulation_seed, replication_id, STREAM_ARRIVALS, store);
+        rng_seed(&customers, simulation_seed, replication_id, STREAM_CUSTOMERS, store);
+
+        double clock = 0.0;
+        int produced;
+        do {
+            produced = generate_arrival_times(&arrival_curve, &arrivals, &clock, 86400.0, times, ARRIVAL_BATCH);
+            fill_cart_sizes(&customers, carts, produced);
+            for (int i = 0; i < produced; i++) items += carts[i];
+            total += produced;
+        } while (produced == ARRIVAL_BATCH);
+    }
+    double elapsed = wall_seconds() - start;
+
+    printf("Generated a day of arrivals for %d stores: %lld customers, %.1f items/cart, in %.2f ms (%.1f ns/customer)\n",
+           stores, total, total > 0 ? (double)items / total : 0.0, elapsed * 1000.0,
+           total > 0 ? elapsed * 1e9 / total : 0.0);
+    free(times);
+    free(carts);
+}
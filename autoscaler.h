@@ -0,0 +1,164 @@
+#include "structs.h"
+#include <pthread.h>
+
+Uint32 next_autoscale_time = 0;
+Uint32 last_scale_change_time = 0;
+Uint32 last_autoscale_tick = 0;
+double staffed_lane_ms = 0.0;
+int peak_open_cashiers = 0;
+int lanes_opened = 0;
+int lanes_closed = 0;
+
+int count_staffed_cashiers() {
+    int staffed = 0;
+    for (int i = 0; i < cashier_count; i++) {
+        if (cashier_lane(i)->status != LANE_CLOSED) staffed++;
+    }
+    return staffed;
+}
+
+int open_unrestricted_lanes() {
+    int open = 0;
+    for (int i = 0; i < total_lane_count(); i++) {
+        if (all_lanes[i].status == LANE_OPEN && all_lanes[i].max_items == 0) open++;
+    }
+    return open;
+}
+
+// Express lanes come first, so the minimum staff alone may not take a full
+// cart; the first unrestricted cashier is then opened as well.
+void init_autoscaler() {
+    if (!autoscale_enabled) return;
+
+    int open = autoscale_min_cashiers < cashier_count ? autoscale_min_cashiers : cashier_count;
+    if (open < 1) open = 1;
+    for (int i = 0; i < cashier_count; i++) {
+        set_lane_status(cashier_lane(i), i < open ? LANE_OPEN : LANE_CLOSED);
+    }
+    for (int i = open; i < cashier_count && open_unrestricted_lanes() == 0; i++) {
+        if (cashier_lane(i)->max_items != 0) continue;
+        set_lane_status(cashier_lane(i), LANE_OPEN);
+        open++;
+    }
+
+    Uint32 now = sim_ticks();
+    last_autoscale_tick = now;
+    last_scale_change_time = now;
+    next_autoscale_time = now + autoscale_interval_ms;
+    peak_open_cashiers = open;
+}
+
+float expected_lane_wait() {
+    float total_wait = 0.0f;
+    int open_lanes = 0;
+
+    for (int i = 0; i < total_lane_count(); i++) {
+        Lane* lane = &all_lanes[i];
+        if (lane->status != LANE_OPEN) continue;
+        pthread_mutex_lock(&lane->queue->lock);
+        total_wait += lane_routing_speed(lane) * lane->queue->total_items;
+        pthread_mutex_unlock(&lane->queue->lock);
+        if (lane->line != NULL) {
+            total_wait += lane_routing_speed(lane) * shared_line_share(lane->line, priority_class_count - 1);
+        }
+        total_wait += lane_remaining_seconds(lane);
+        open_lanes++;
+    }
+
+    return open_lanes > 0 ? total_wait / open_lanes : FLT_MAX;
+}
+
+void finish_draining_lanes() {
+    for (int i = 0; i < cashier_count; i++) {
+        Lane* cashier = cashier_lane(i);
+        if (cashier->status != LANE_DRAINING) continue;
+
+        pthread_mutex_lock(&cashier->queue->lock);
+        bool empty = cashier->queue->size == 0;
+        pthread_mutex_unlock(&cashier->queue->lock);
+
+        if (empty && !cashier->is_serving) {
+            set_lane_status(cashier, LANE_CLOSED);
+            lanes_closed++;
+        }
+    }
+}
+
+void open_one_lane() {
+    for (int i = 0; i < cashier_count; i++) {
+        if (cashier_lane(i)->status == LANE_DRAINING) {
+            set_lane_status(cashier_lane(i), LANE_OPEN);
+            return;
+        }
+    }
+    for (int i = 0; i < cashier_count; i++) {
+        if (cashier_lane(i)->status == LANE_CLOSED) {
+            set_lane_status(cashier_lane(i), LANE_OPEN);
+            lanes_opened++;
+            return;
+        }
+    }
+}
+
+// The last open lane that takes any cart stays open.
+bool drain_one_lane() {
+    bool keep_unrestricted = open_unrestricted_lanes() <= 1;
+    for (int i = cashier_count - 1; i >= 0; i--) {
+        if (keep_unrestricted && cashier_lane(i)->max_items == 0) continue;
+        if (cashier_lane(i)->status == LANE_OPEN) {
+            set_lane_status(cashier_lane(i), LANE_DRAINING);
+            return true;
+        }
+    }
+    return false;
+}
+
+void autoscale_lanes() {
+    if (!autoscale_enabled) return;
+
+    Uint32 now = sim_ticks();
+    staffed_lane_ms += (double)count_staffed_cashiers() * (now - last_autoscale_tick);
+    last_autoscale_tick = now;
+    if (now < next_autoscale_time) return;
+    next_autoscale_time = now + autoscale_interval_ms;
+
+    pthread_mutex_lock(&visualization_lock);
+    finish_draining_lanes();
+
+    int open = 0;
+    for (int i = 0; i < cashier_count; i++) {
+        if (cashier_lane(i)->status == LANE_OPEN) open++;
+    }
+
+    float expected_wait = expected_lane_wait();
+    bool cooled_down = now - last_scale_change_time >= (Uint32)autoscale_cooldown_ms;
+
+    if (cooled_down && expected_wait > autoscale_open_wait && open < cashier_count) {
+        open_one_lane();
+        open++;
+        last_scale_change_time = now;
+    } else if (cooled_down && expected_wait < autoscale_close_wait && open > autoscale_min_cashiers &&
+               drain_one_lane()) {
+        open--;
+        last_scale_change_time = now;
+    }
+    pthread_mutex_unlock(&visualization_lock);
+
+    if (open > peak_open_cashiers) peak_open_cashiers = open;
+}
+
+void print_autoscale_summary() {
+    if (!autoscale_enabled) return;
+
+    float elapsed_s = (sim_ticks() - simulation_start_time) / 1000.0f;
+    float average_staffed = elapsed_s > 0 ? (float)(staffed_lane_ms / 1000.0 / elapsed_s) : 0.0f;
+
+    pthread_mutex_lock(&wait_histogram_lock);
+    float within_slo = histogram_fraction_within(&wait_histogram, (Uint32)(wait_slo * 1000.0f)) * 100.0f;
+    pthread_mutex_unlock(&wait_histogram_lock);
+
+    printf("Autoscaler: %.1f cashier lanes staffed on average (peak %d of %d), %d opened, %d closed, %.1f lane-minutes\n",
+           average_staffed, peak_open_cashiers, cashier_count, lanes_opened, lanes_closed,
+           staffed_lane_ms / 60000.0);
+    printf("Wait SLO %.0f s met for %.1f%% of customers\n", wait_slo, within_slo);
+}
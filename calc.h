@@ -1,102 +1,183 @@
 #include "structs.h"
+#include <math.h>
 #include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
 
-Cashier* get_least_busy_cashier() {
-    int min_size = INT_MAX;
-    Cashier* best_cashier = NULL;
+// Packed routing inputs, one float per lane and padded to whole vectors. They
+// are kept current where the lane changes (queue inserts and removals, service
+// start and end, speed and status changes), so routing reads them without
+// taking any lane lock; a slot may be one update behind. Each slot is only
+// written under its queue lock or by its lane's own thread.
+//
+// lane_class_items: queued items per priority class.
+// lane_busy_until: seconds since the start at which the current service is
+//   expected to end, 0 when idle.
+// lane_closed: 0 while open, infinity otherwise; padding slots stay closed.
+// lane_line_weight: 1 for the members of each shared line.
+LaneVector* lane_class_items[MAX_PRIORITY_CLASSES];
+LaneVector* lane_speed_seconds = NULL;
+LaneVector* lane_busy_until = NULL;
+LaneVector* lane_closed = NULL;
+LaneVector* lane_line_weight[MAX_SHARED_LINES];
+int lane_vector_count = 0;
 
-    for (int i = 0; i < cashier_count; i++) {
-        pthread_mutex_lock(&all_cashiers[i]->queue->lock);
-        if (all_cashiers[i]->queue->size < min_size) {
-            min_size = all_cashiers[i]->queue->size;
-            best_cashier = all_cashiers[i];
-        }
-        pthread_mutex_unlock(&all_cashiers[i]->queue->lock);
+LaneVector* alloc_lane_vectors(int rows, float fill) {
+    LaneVector* v = (LaneVector*)aligned_alloc(sizeof(LaneVector), sizeof(LaneVector) * lane_vector_count * rows);
+    for (int i = 0; i < lane_vector_count * rows; i++) v[i] = (LaneVector){0} + fill;
+    return v;
+}
+
+float* lane_slot(LaneVector* v, int lane) {
+    return (float*)v + lane;
+}
+
+void track_lane_speed(Lane* lane) {
+    *lane_slot(lane_speed_seconds, lane_index(lane)) = lane_routing_speed(lane);
+}
+
+void track_lane_status(Lane* lane) {
+    *lane_slot(lane_closed, lane_index(lane)) = lane->status == LANE_OPEN ? 0.0f : INFINITY;
+}
+
+void track_queued_items(int lane, int priority, int items) {
+    if (lane < 0 || lane_vector_count == 0) return;
+    *lane_slot(lane_class_items[priority], lane) += (float)items;
+}
+
+void track_service(Lane* lane, Customer* c) {
+    float until = 0.0f;
+    if (c != NULL) {
+        until = (c->service_start_time - simulation_start_time) / 1000.0f + lane_routing_speed(lane) * c->items;
     }
-    return best_cashier;
+    *lane_slot(lane_busy_until, lane_index(lane)) = until;
+}
+
+void track_line_member(int lane, int line) {
+    *lane_slot(lane_line_weight[line], lane) = 1.0f;
 }
 
-float calculate_cashier_score(Cashier* cashier, Customer* customer) {
-    float estimated_service_time = cashier->avg_service_time_per_item * customer->items;
-    float queue_waiting_time = 0.0;
-    
-    pthread_mutex_lock(&cashier->queue->lock);
-    Node* current = cashier->queue->front;
-    while (current != NULL) {
-        Customer* queued_customer = current->data;
-        queue_waiting_time += cashier->avg_service_time_per_item * queued_customer->items;
-        current = current->next;
+void init_lane_vectors() {
+    lane_vector_count = (total_lane_count() + LANE_VECTOR_WIDTH - 1) / LANE_VECTOR_WIDTH;
+    if (lane_vector_count == 0) lane_vector_count = 1;
+    for (int k = 0; k < MAX_PRIORITY_CLASSES; k++) lane_class_items[k] = alloc_lane_vectors(1, 0.0f);
+    for (int l = 0; l < MAX_SHARED_LINES; l++) lane_line_weight[l] = alloc_lane_vectors(1, 0.0f);
+    lane_speed_seconds = alloc_lane_vectors(1, 0.0f);
+    lane_busy_until = alloc_lane_vectors(1, 0.0f);
+    lane_closed = alloc_lane_vectors(1, INFINITY);
+    for (int i = 0; i < total_lane_count(); i++) {
+        all_lanes[i].queue->lane = i;
+        track_lane_speed(&all_lanes[i]);
+        track_lane_status(&all_lanes[i]);
     }
-    pthread_mutex_unlock(&cashier->queue->lock);
-    
-    if (cashier->is_serving && cashier->current_customer != NULL) {
-        Uint32 elapsed_time_ms = SDL_GetTicks() - cashier->current_customer->service_start_time;
+}
+
+void free_lane_vectors() {
+    for (int k = 0; k < MAX_PRIORITY_CLASSES; k++) free(lane_class_items[k]);
+    for (int l = 0; l < MAX_SHARED_LINES; l++) free(lane_line_weight[l]);
+    free(lane_speed_seconds);
+    free(lane_busy_until);
+    free(lane_closed);
+    memset(lane_class_items, 0, sizeof(lane_class_items));
+    memset(lane_line_weight, 0, sizeof(lane_line_weight));
+    lane_speed_seconds = NULL;
+    lane_busy_until = NULL;
+    lane_closed = NULL;
+    lane_vector_count = 0;
+}
+
+float lane_remaining_seconds(Lane* lane) {
+    if (lane->is_serving && lane->current_customer != NULL) {
+        Uint32 elapsed_time_ms = sim_ticks() - lane->current_customer->service_start_time;
         float elapsed_time = elapsed_time_ms / 1000.0f;
-        float total_service_time = cashier->avg_service_time_per_item * cashier->current_customer->items;
+        float total_service_time = lane_routing_speed(lane) * lane->current_customer->items;
         float remaining_time = total_service_time - elapsed_time;
         if (remaining_time > 0) {
-            queue_waiting_time += remaining_time;
+            return remaining_time;
         }
     }
-    
-    float total_time = queue_waiting_time + estimated_service_time;
-    
-    return total_time;
+    return 0.0f;
 }
 
-float calculate_kiosk_score(SelfCheckout* kiosk, Customer* customer) {
-    
-    float estimated_service_time = kiosk->avg_service_time_per_item * customer->items;
-    float queue_waiting_time = 0.0;
-    
-    pthread_mutex_lock(&kiosk->queue->lock);
-    Node* current = kiosk->queue->front;
-    while (current != NULL) {
-        Customer* queued_customer = current->data;
-        queue_waiting_time += kiosk->avg_service_time_per_item * queued_customer->items;
-        current = current->next;
+float routing_now() {
+    return (sim_ticks() - simulation_start_time) / 1000.0f;
+}
+
+// Items a new customer of this priority would wait behind in each shared
+// line, spread over the line's open members.
+void line_shares(int priority, float* shares) {
+    for (int l = 0; l < shared_line_count; l++) {
+        shares[l] = shared_line_share(&shared_lines[l], priority);
     }
-    pthread_mutex_unlock(&kiosk->queue->lock);
-    
-    if (kiosk->is_serving && kiosk->current_customer != NULL) {
-        Uint32 elapsed_time_ms = SDL_GetTicks() - kiosk->current_customer->service_start_time;
-        float elapsed_time = elapsed_time_ms / 1000.0f;
-        float total_service_time = kiosk->avg_service_time_per_item * kiosk->current_customer->items;
-        float remaining_time = total_service_time - elapsed_time;
-        if (remaining_time > 0) {
-            queue_waiting_time += remaining_time;
-        }
+}
+
+// Seconds of work ahead of a new customer of this priority.
+float lane_pending_work(Lane* lane, int priority) {
+    int i = lane_index(lane);
+    float items = 0.0f;
+    for (int k = 0; k <= priority; k++) items += *lane_slot(lane_class_items[k], i);
+    if (lane->line != NULL) {
+        items += shared_line_share(lane->line, priority);
     }
-    
-    float total_time = queue_waiting_time + estimated_service_time;
-    return total_time;
+    float remaining = *lane_slot(lane_busy_until, i) - routing_now();
+    return *lane_slot(lane_speed_seconds, i) * items + (remaining > 0.0f ? remaining : 0.0f);
 }
 
-CheckoutOption get_best_checkout_option(Customer* customer) {
-    float best_score = FLT_MAX;
-    CheckoutOption best_option;
-    best_option.type = NONE;
-    best_option.index = -1;
-    
-    for (int i = 0; i < cashier_count; i++) {
-        float score = calculate_cashier_score(all_cashiers[i], customer);
-        
-        if (score < best_score) {
-            best_score = score;
-            best_option.type = CASHIER;
-            best_option.index = i;
+float lane_score(Lane* lane, Customer* customer) {
+    return lane_pending_work(lane, customer->priority) + lane_routing_speed(lane) * customer->items;
+}
+
+// Every lane's finish time comes from the packed slots in a few vector ops:
+// queued items ahead by class, the shared-line share, the customer's own cart
+// and what is left of the current service. Closed and ineligible lanes add
+// infinity. Ties go to the lowest lane, as a scalar scan in lane order would.
+Lane* best_lane_among(Customer* customer, const uint64_t* eligible) {
+    int priority = customer->priority;
+    float shares[MAX_SHARED_LINES];
+    line_shares(priority, shares);
+    LaneVector now = (LaneVector){0} + routing_now();
+    LaneVector items = (LaneVector){0} + (float)customer->items;
+    LaneVector infinity = (LaneVector){0} + INFINITY;
+
+    LaneIndexVector index;
+    lane_vector_offsets(&index);
+    LaneVector best = infinity;
+    LaneIndexVector best_index = index;
+    for (int v = 0; v < lane_vector_count; v++) {
+        LaneVector ahead = items;
+        for (int k = 0; k <= priority; k++) ahead += lane_class_items[k][v];
+        for (int l = 0; l < shared_line_count; l++) ahead += lane_line_weight[l][v] * shares[l];
+        LaneVector remaining = lane_busy_until[v] - now;
+        remaining = (LaneVector)((LaneIndexVector)remaining & (remaining > 0.0f));
+        LaneVector finish = lane_speed_seconds[v] * ahead + remaining + lane_closed[v];
+        if (eligible != NULL) {
+            LaneIndexVector admitted;
+            admitted_lanes(eligible, v, &admitted);
+            finish = (LaneVector)(((LaneIndexVector)finish & admitted) | ((LaneIndexVector)infinity & ~admitted));
         }
+
+        LaneIndexVector better = finish < best;
+        best = (LaneVector)(((LaneIndexVector)finish & better) | ((LaneIndexVector)best & ~better));
+        best_index = (index & better) | (best_index & ~better);
+        index += LANE_VECTOR_WIDTH;
     }
-    
-    for (int i = 0; i < selfcheckout_count; i++) {
-        float score = calculate_kiosk_score(all_kiosks[i], customer);
-        
-        if (score < best_score) {
-            best_score = score;
-            best_option.type = KIOSK;
-            best_option.index = i;
+
+    float best_score = INFINITY;
+    int best_lane = -1;
+    for (int i = 0; i < LANE_VECTOR_WIDTH; i++) {
+        if (best[i] < best_score || (best[i] == best_score && best_index[i] < best_lane)) {
+            best_score = best[i];
+            best_lane = best_index[i];
         }
     }
-    
-    return best_option;
+    return best_lane < 0 ? NULL : &all_lanes[best_lane];
+}
+
+// Only lanes whose class admits the cart are scored. NULL means none of them
+// is open, and the customer balks.
+Lane* get_best_lane(Customer* customer) {
+    if (lane_eligibility.bits != NULL) {
+        return best_lane_among(customer, eligible_lanes(&lane_eligibility, customer->items));
+    }
+    return best_lane_among(customer, NULL);
 }
\ No newline at end of file
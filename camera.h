@@ -0,0 +1,308 @@
+#include "structs.h"
+#include <stdlib.h>
+
+#define CASHIER_LANE_PITCH 140
+#define KIOSK_ROW_PITCH 110
+#define KIOSK_AREA_WIDTH (SCREEN_WIDTH / 4)
+#define CAMERA_MAX_ZOOM 2.0f
+#define CAMERA_PAN_PIXELS 100
+#define LOD_ZOOM 0.45f
+#define HEAT_LEVELS 5
+#define HEAT_PIXELS_PER_CUSTOMER 6
+#define HEAT_MAX_DEPTH 40
+
+Camera camera = {0.0f, 0.0f, 1.0f, 1.0f, false};
+float cashier_pitch = SCREEN_WIDTH;
+int kiosk_row_height = 0;
+int kiosk_area_x = SCREEN_WIDTH * 3 / 4;
+int world_width = SCREEN_WIDTH;
+int world_height = SCREEN_HEIGHT;
+
+SDL_Rect* heat_rects[HEAT_LEVELS];
+int heat_counts[HEAT_LEVELS];
+SDL_Rect* counter_rects = NULL;
+int counter_count = 0;
+
+const SDL_Color heat_colors[HEAT_LEVELS] = {
+    {170, 200, 170, 255},
+    {60, 170, 80, 255},
+    {230, 200, 40, 255},
+    {240, 130, 30, 255},
+    {210, 40, 40, 255}
+};
+
+int screen_x(float x) {
+    return (int)((x - camera.x) * camera.zoom);
+}
+
+int screen_y(float y) {
+    return (int)((y - camera.y) * camera.zoom);
+}
+
+SDL_Rect screen_rect(float x, float y, int w, int h) {
+    SDL_Rect rect = {screen_x(x), screen_y(y), (int)(w * camera.zoom + 0.5f), (int)(h * camera.zoom + 0.5f)};
+    if (rect.w < 1) rect.w = 1;
+    if (rect.h < 1) rect.h = 1;
+    return rect;
+}
+
+float view_width() {
+    return SCREEN_WIDTH / camera.zoom;
+}
+
+float view_height() {
+    return SCREEN_HEIGHT / camera.zoom;
+}
+
+bool world_visible(float x, float y, int w, int h) {
+    return x + w >= camera.x && x <= camera.x + view_width() &&
+           y + h >= camera.y && y <= camera.y + view_height();
+}
+
+// Zoomed out, lanes are drawn as aggregated heat bars instead of sprites and labels.
+bool camera_detail() {
+    return camera.zoom >= LOD_ZOOM;
+}
+
+// Lanes keep a fixed world spacing once they no longer fit in the window; the
+// camera then decides which part of the store is on screen.
+void layout_store() {
+    float cashier_area_width = selfcheckout_count > 0 ? SCREEN_WIDTH * 3 / 4 : SCREEN_WIDTH;
+    if ((cashier_count + 1) * CASHIER_LANE_PITCH > cashier_area_width) {
+        cashier_area_width = (cashier_count + 1) * CASHIER_LANE_PITCH;
+    }
+    cashier_pitch = cashier_area_width / (cashier_count + 1);
+    kiosk_area_x = (int)cashier_area_width;
+    world_width = kiosk_area_x + (selfcheckout_count > 0 ? KIOSK_AREA_WIDTH : 0);
+
+    world_height = SCREEN_HEIGHT;
+    if (selfcheckout_count > 0) {
+        kiosk_row_height = (SCREEN_HEIGHT - 150) / selfcheckout_count;
+        if (kiosk_row_height < KIOSK_ROW_PITCH) kiosk_row_height = KIOSK_ROW_PITCH;
+        if (120 + kiosk_row_height * selfcheckout_count + 30 > world_height) {
+            world_height = 120 + kiosk_row_height * selfcheckout_count + 30;
+        }
+    }
+
+    int lanes = cashier_count + selfcheckout_count;
+    for (int level = 0; level < HEAT_LEVELS; level++) {
+        heat_rects[level] = (SDL_Rect*)malloc(sizeof(SDL_Rect) * (lanes > 0 ? lanes : 1));
+    }
+    counter_rects = (SDL_Rect*)malloc(sizeof(SDL_Rect) * (lanes > 0 ? lanes : 1));
+}
+
+void camera_clamp() {
+    if (camera.zoom < camera.min_zoom) camera.zoom = camera.min_zoom;
+    if (camera.zoom > CAMERA_MAX_ZOOM) camera.zoom = CAMERA_MAX_ZOOM;
+
+    float w = view_width();
+    float h = view_height();
+    if (world_width <= w) camera.x = (world_width - w) / 2;
+    else if (camera.x < 0) camera.x = 0;
+    else if (camera.x > world_width - w) camera.x = world_width - w;
+    if (world_height <= h) camera.y = (world_height - h) / 2;
+    else if (camera.y < 0) camera.y = 0;
+    else if (camera.y > world_height - h) camera.y = world_height - h;
+}
+
+void camera_fit() {
+    float zoom_x = (float)SCREEN_WIDTH / world_width;
+    float zoom_y = (float)SCREEN_HEIGHT / world_height;
+    camera.zoom = zoom_x < zoom_y ? zoom_x : zoom_y;
+    if (camera.zoom > 1.0f) camera.zoom = 1.0f;
+    camera.min_zoom = camera.zoom;
+    camera.x = 0;
+    camera.y = 0;
+    camera_clamp();
+}
+
+void camera_zoom_at(float factor, int sx, int sy) {
+    float wx = camera.x + sx / camera.zoom;
+    float wy = camera.y + sy / camera.zoom;
+    camera.zoom *= factor;
+    camera_clamp();
+    camera.x = wx - sx / camera.zoom;
+    camera.y = wy - sy / camera.zoom;
+    camera_clamp();
+}
+
+// Returns true when the event moved the camera.
+bool camera_handle_event(SDL_Event* event) {
+    switch (event->type) {
+        case SDL_MOUSEWHEEL: {
+            if (event->wheel.y == 0) return false;
+            int mx, my;
+            SDL_GetMouseState(&mx, &my);
+            camera_zoom_at(event->wheel.y > 0 ? 1.25f : 0.8f, mx, my);
+            return true;
+        }
+        case SDL_MOUSEBUTTONDOWN:
+            if (event->button.button == SDL_BUTTON_LEFT) camera.dragging = true;
+            return false;
+        case SDL_MOUSEBUTTONUP:
+            if (event->button.button == SDL_BUTTON_LEFT) camera.dragging = false;
+            return false;
+        case SDL_MOUSEMOTION:
+            if (!camera.dragging) return false;
+            camera.x -= event->motion.xrel / camera.zoom;
+            camera.y -= event->motion.yrel / camera.zoom;
+            camera_clamp();
+            return true;
+        case SDL_KEYDOWN:
+            switch (event->key.keysym.sym) {
+                case SDLK_LEFT: camera.x -= CAMERA_PAN_PIXELS / camera.zoom; break;
+                case SDLK_RIGHT: camera.x += CAMERA_PAN_PIXELS / camera.zoom; break;
+                case SDLK_UP: camera.y -= CAMERA_PAN_PIXELS / camera.zoom; break;
+                case SDLK_DOWN: camera.y += CAMERA_PAN_PIXELS / camera.zoom; break;
+                case SDLK_EQUALS:
+                case SDLK_PLUS:
+                case SDLK_KP_PLUS: camera_zoom_at(1.25f, SCREEN_WIDTH / 2, SCREEN_HEIGHT / 2); return true;
+                case SDLK_MINUS:
+                case SDLK_KP_MINUS: camera_zoom_at(0.8f, SCREEN_WIDTH / 2, SCREEN_HEIGHT / 2); return true;
+                case SDLK_0:
+                case SDLK_HOME: camera_fit(); return true;
+                default: return false;
+            }
+            camera_clamp();
+            return true;
+    }
+    return false;
+}
+
+// Lanes are evenly spaced, so the visible range comes straight from the
+// camera instead of testing every lane.
+void visible_cashiers(int* first, int* last) {
+    *first = (int)(camera.x / cashier_pitch) - 2;
+    *last = (int)((camera.x + view_width()) / cashier_pitch) + 1;
+    if (*first < 0) *first = 0;
+    if (*last > cashier_count - 1) *last = cashier_count - 1;
+}
+
+void visible_kiosks(int* first, int* last) {
+    if (kiosk_row_height <= 0) {
+        *first = 0;
+        *last = -1;
+        return;
+    }
+    *first = (int)((camera.y - 120) / kiosk_row_height) - 1;
+    *last = (int)((camera.y + view_height() - 120) / kiosk_row_height) + 1;
+    if (*first < 0) *first = 0;
+    if (*last > selfcheckout_count - 1) *last = selfcheckout_count - 1;
+}
+
+int heat_level(int depth) {
+    if (depth <= 0) return 0;
+    if (depth <= 2) return 1;
+    if (depth <= 5) return 2;
+    if (depth <= 9) return 3;
+    return 4;
+}
+
+int heat_length(int depth) {
+    return (depth < HEAT_MAX_DEPTH ? depth : HEAT_MAX_DEPTH) * HEAT_PIXELS_PER_CUSTOMER;
+}
+
+// Several lanes that land on the same screen column or row share one bar
+// showing the deepest of their queues.
+void draw_cashier_heat() {
+    int first, last;
+    visible_cashiers(&first, &last);
+
+    int bar_x = INT_MIN;
+    int bar_w = 0;
+    int bar_y = 0;
+    int depth = -1;
+    for (int i = first; i <= last + 1; i++) {
+        SDL_Rect counter = {0, 0, 0, 0};
+        int lane_depth = 0;
+        if (i <= last) {
+            Lane* cashier = cashier_lane(i);
+            counter = screen_rect(cashier->x - TABLE_WIDTH / 2, cashier->y, TABLE_WIDTH, TABLE_HEIGHT);
+            if (counter.h < 4) counter.h = 4;
+            if (counter.x == bar_x) {
+                if (cashier->status != LANE_CLOSED) {
+                    lane_depth = lane_queue_length(i);
+                    if (lane_depth > depth) depth = lane_depth;
+                }
+                continue;
+            }
+            lane_depth = cashier->status == LANE_CLOSED ? -1 : lane_queue_length(i);
+        }
+
+        if (depth >= 0) {
+            SDL_Rect bar = {bar_x, bar_y, bar_w, heat_length(depth) + 2};
+            int level = heat_level(depth);
+            heat_rects[level][heat_counts[level]++] = bar;
+        }
+        if (i > last) break;
+
+        counter_rects[counter_count++] = counter;
+        bar_x = counter.x;
+        bar_w = counter.w;
+        bar_y = counter.y + counter.h;
+        depth = lane_depth;
+    }
+}
+
+void draw_kiosk_heat() {
+    int first, last;
+    visible_kiosks(&first, &last);
+
+    int bar_x = screen_x(kiosk_area_x + 20);
+    int bar_y = INT_MIN;
+    int bar_h = 0;
+    int depth = -1;
+    for (int i = first; i <= last + 1; i++) {
+        SDL_Rect counter = {0, 0, 0, 0};
+        int lane_depth = 0;
+        if (i <= last) {
+            Lane* kiosk = kiosk_lane(i);
+            counter = screen_rect(kiosk->x - SELFCHECKOUT_WIDTH / 2, kiosk->y - kiosk_row_height * 3 / 10,
+                                  SELFCHECKOUT_WIDTH, kiosk_row_height * 6 / 10);
+            if (counter.y == bar_y) {
+                lane_depth = lane_queue_length(cashier_count + i);
+                if (lane_depth > depth) depth = lane_depth;
+                continue;
+            }
+            lane_depth = lane_queue_length(cashier_count + i);
+        }
+
+        if (depth >= 0) {
+            SDL_Rect bar = {bar_x, bar_y, heat_length(depth) + 2, bar_h};
+            int level = heat_level(depth);
+            heat_rects[level][heat_counts[level]++] = bar;
+        }
+        if (i > last) break;
+
+        counter_rects[counter_count++] = counter;
+        bar_y = counter.y;
+        bar_h = counter.h;
+        depth = lane_depth;
+    }
+}
+
+void draw_lane_heat() {
+    counter_count = 0;
+    for (int level = 0; level < HEAT_LEVELS; level++) heat_counts[level] = 0;
+
+    draw_cashier_heat();
+    draw_kiosk_heat();
+
+    SDL_SetRenderDrawColor(renderer, 128, 128, 128, 255);
+    if (counter_count > 0) SDL_RenderFillRects(renderer, counter_rects, counter_count);
+    for (int level = 0; level < HEAT_LEVELS; level++) {
+        if (heat_counts[level] == 0) continue;
+        SDL_Color color = heat_colors[level];
+        SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
+        SDL_RenderFillRects(renderer, heat_rects[level], heat_counts[level]);
+    }
+}
+
+void free_camera() {
+    for (int level = 0; level < HEAT_LEVELS; level++) {
+        free(heat_rects[level]);
+        heat_rects[level] = NULL;
+    }
+    free(counter_rects);
+    counter_rects = NULL;
+}
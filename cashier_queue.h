@@ -1,48 +1,135 @@
 #include <pthread.h>
+#include <errno.h>
+#include <string.h>
 
 Queue* create_queue() {
     Queue* q = (Queue*)malloc(sizeof(Queue));
     q->front = q->rear = NULL;
     q->size = 0;
+    q->total_items = 0;
+    memset(q->class_tail, 0, sizeof(q->class_tail));
+    memset(q->class_items, 0, sizeof(q->class_items));
+    q->lane = -1;
     pthread_mutex_init(&q->lock, NULL);
     pthread_cond_init(&q->cond, NULL);
     return q;
 }
 
-void enqueue(Queue* q, Customer c) {
+// The lane is one list ordered by class, then arrival. A customer goes in
+// behind the last customer of the nearest class at or above its own, so
+// insertion stays O(1) and pops from either end need no search.
+void insert_by_priority_locked(Queue* q, Node* node) {
+    int priority = node->data->priority;
+    Node* after = NULL;
+    for (int k = priority; k >= 0 && after == NULL; k--) after = q->class_tail[k];
+
+    node->prev = after;
+    node->next = after ? after->next : q->front;
+    if (node->next) node->next->prev = node;
+    else q->rear = node;
+    if (after) after->next = node;
+    else q->front = node;
+
+    q->class_tail[priority] = node;
+    q->class_items[priority] += node->data->items;
+    track_queued_items(q->lane, priority, node->data->items);
+    q->size++;
+    q->total_items += node->data->items;
+}
+
+void enqueue(Queue* q, Customer* c) {
     Node* newNode = (Node*)malloc(sizeof(Node));
     newNode->data = c;
     newNode->next = NULL;
 
     pthread_mutex_lock(&q->lock);
-    if (!q->rear) {
-        q->front = q->rear = newNode;
-    } else {
-        q->rear->next = newNode;
-        q->rear = newNode;
-    }
-    q->size++;
+    insert_by_priority_locked(q, newNode);
     pthread_cond_signal(&q->cond);  
     pthread_mutex_unlock(&q->lock);
 }
 
-Customer dequeue(Queue* q) {
+Customer* unlink_node_locked(Queue* q, Node* node) {
+    Customer* c = node->data;
+    if (node->prev) node->prev->next = node->next;
+    else q->front = node->next;
+    if (node->next) node->next->prev = node->prev;
+    else q->rear = node->prev;
+
+    if (q->class_tail[c->priority] == node) {
+        Node* prev = node->prev;
+        q->class_tail[c->priority] = prev && prev->data->priority == c->priority ? prev : NULL;
+    }
+    q->class_items[c->priority] -= c->items;
+    track_queued_items(q->lane, c->priority, -c->items);
+    q->size--;
+    q->total_items -= c->items;
+
+    free(node);
+    return c;
+}
+
+int items_ahead_locked(Queue* q, int priority) {
+    int items = 0;
+    for (int k = 0; k <= priority; k++) items += q->class_items[k];
+    return items;
+}
+
+Customer* pop_front_locked(Queue* q) {
+    return unlink_node_locked(q, q->front);
+}
+
+Customer* dequeue(Queue* q) {
     pthread_mutex_lock(&q->lock);
     while (q->size == 0) {
         if (all_customers_served) {  
             pthread_mutex_unlock(&q->lock);
-            return (Customer){-1, 0, 0};  
+            return NULL;  
         }
         pthread_cond_wait(&q->cond, &q->lock);
     }
 
-    Node* temp = q->front;
-    Customer c = temp->data;
-    q->front = q->front->next;
-    if (!q->front) q->rear = NULL;
-    q->size--;
+    Customer* c = pop_front_locked(q);
+    pthread_mutex_unlock(&q->lock);
+    return c;
+}
+
+Customer* dequeue_timeout(Queue* q, int timeout_ms) {
+    struct timespec deadline = deadline_after_ms(clock_real_ms(timeout_ms));
+
+    pthread_mutex_lock(&q->lock);
+    while (q->size == 0) {
+        if (all_customers_served ||
+            pthread_cond_timedwait(&q->cond, &q->lock, &deadline) == ETIMEDOUT) {
+            break;
+        }
+    }
+
+    Customer* c = q->size > 0 ? pop_front_locked(q) : NULL;
+    pthread_mutex_unlock(&q->lock);
+    return c;
+}
+
+Customer* pop_back_locked(Queue* q) {
+    return unlink_node_locked(q, q->rear);
+}
+
+bool remove_customer_locked(Queue* q, Customer* c) {
+    Node* node = q->front;
+    while (node != NULL && node->data != c) node = node->next;
+    if (node == NULL) return false;
+
+    unlink_node_locked(q, node);
+    return true;
+}
+
+Customer* steal_tail(Queue* q, int min_size) {
+    pthread_mutex_lock(&q->lock);
+    if (q->size < min_size || !q->rear) {
+        pthread_mutex_unlock(&q->lock);
+        return NULL;
+    }
 
-    free(temp);
+    Customer* c = pop_back_locked(q);
     pthread_mutex_unlock(&q->lock);
     return c;
 }
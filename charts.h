@@ -0,0 +1,239 @@
+#include "structs.h"
+#include <pthread.h>
+#include <string.h>
+
+#define CHART_PANEL_HEIGHT 150
+#define CHART_LANE_COLUMNS 8
+
+TimeSeries* lane_queue_series = NULL;
+TimeSeries store_queue_series;
+TimeSeries throughput_series;
+int chart_lane_count = 0;
+int last_served_sample = 0;
+Uint32 next_chart_sample = 0;
+
+SDL_Point queue_line[SERIES_CAPACITY];
+SDL_Point throughput_line[SERIES_CAPACITY];
+int queue_line_count = 0;
+int throughput_line_count = 0;
+SDL_Rect* lane_bars = NULL;
+int lane_bar_count = 0;
+int lane_bar_capacity = 0;
+
+CachedLabel queue_label;
+CachedLabel throughput_label;
+CachedLabel* lane_labels = NULL;
+
+Uint64 chart_draw_ticks = 0;
+int chart_frames = 0;
+
+void series_push(TimeSeries* s, float value) {
+    s->values[s->head] = value;
+    s->head = (s->head + 1) % SERIES_CAPACITY;
+    if (s->count < SERIES_CAPACITY) s->count++;
+}
+
+// Oldest first, so index 0 is the left edge of a chart.
+float series_at(const TimeSeries* s, int index) {
+    int start = (s->head - s->count + SERIES_CAPACITY) % SERIES_CAPACITY;
+    return s->values[(start + index) % SERIES_CAPACITY];
+}
+
+float series_max(const TimeSeries* s) {
+    float max = 0.0f;
+    for (int i = 0; i < s->count; i++) {
+        if (s->values[i] > max) max = s->values[i];
+    }
+    return max;
+}
+
+void draw_cached_label(CachedLabel* label, const char* text, int x, int y, SDL_Color color) {
+    if (label->texture == NULL || strcmp(label->text, text) != 0) {
+        if (label->texture) SDL_DestroyTexture(label->texture);
+        snprintf(label->text, sizeof(label->text), "%s", text);
+        label->texture = renderText(renderer, font, text, color);
+        if (label->texture) SDL_QueryTexture(label->texture, NULL, NULL, &label->width, &label->height);
+    }
+    if (label->texture == NULL) return;
+    SDL_Rect rect = {x, y, label->width * 14 / label->height, 14};
+    SDL_RenderCopy(renderer, label->texture, NULL, &rect);
+}
+
+void free_cached_label(CachedLabel* label) {
+    if (label->texture) SDL_DestroyTexture(label->texture);
+    label->texture = NULL;
+    label->text[0] = '\0';
+}
+
+void init_charts() {
+    chart_lane_count = cashier_count + selfcheckout_count;
+    lane_queue_series = (TimeSeries*)calloc(chart_lane_count > 0 ? chart_lane_count : 1, sizeof(TimeSeries));
+    lane_labels = (CachedLabel*)calloc(chart_lane_count > 0 ? chart_lane_count : 1, sizeof(CachedLabel));
+    memset(&store_queue_series, 0, sizeof(TimeSeries));
+    memset(&throughput_series, 0, sizeof(TimeSeries));
+    next_chart_sample = sim_ticks();
+}
+
+bool chart_lane_labels() {
+    return chart_lane_count <= CHART_LANE_COLUMNS * 2;
+}
+
+SDL_Rect chart_panel_rect() {
+    int width = (selfcheckout_count > 0 ? SCREEN_WIDTH * 3 / 4 : SCREEN_WIDTH) - 20;
+    SDL_Rect panel = {10, 55, width, CHART_PANEL_HEIGHT};
+    return panel;
+}
+
+void build_line(const TimeSeries* s, SDL_Rect area, SDL_Point* out, int* count) {
+    float max = series_max(s);
+    if (max < 1.0f) max = 1.0f;
+    *count = s->count;
+    for (int i = 0; i < s->count; i++) {
+        out[i].x = area.x + i * area.w / SERIES_CAPACITY;
+        out[i].y = area.y + area.h - (int)(series_at(s, i) / max * area.h);
+    }
+}
+
+// Geometry only changes when a sample arrives, so it is rebuilt here rather
+// than every frame.
+void build_chart_geometry() {
+    SDL_Rect panel = chart_panel_rect();
+    int half = panel.w / 2;
+
+    SDL_Rect queue_area = {panel.x + 5, panel.y + 20, half - 10, panel.h / 2 - 30};
+    SDL_Rect throughput_area = {panel.x + 5, panel.y + panel.h / 2 + 20, half - 10, panel.h / 2 - 30};
+    build_line(&store_queue_series, queue_area, queue_line, &queue_line_count);
+    build_line(&throughput_series, throughput_area, throughput_line, &throughput_line_count);
+
+    if (chart_lane_count == 0) return;
+    int columns = chart_lane_count < CHART_LANE_COLUMNS ? chart_lane_count : CHART_LANE_COLUMNS;
+    int rows = (chart_lane_count + columns - 1) / columns;
+    int cell_w = (panel.w - half) / columns;
+    int cell_h = panel.h / rows;
+    int bars = cell_w - 4 < SERIES_CAPACITY ? cell_w - 4 : SERIES_CAPACITY;
+    if (bars < 1) bars = 1;
+
+    if (lane_bar_capacity < chart_lane_count * bars) {
+        lane_bar_capacity = chart_lane_count * bars;
+        lane_bars = (SDL_Rect*)realloc(lane_bars, sizeof(SDL_Rect) * lane_bar_capacity);
+    }
+
+    float lane_max = 1.0f;
+    for (int lane = 0; lane < chart_lane_count; lane++) {
+        float max = series_max(&lane_queue_series[lane]);
+        if (max > lane_max) lane_max = max;
+    }
+
+    lane_bar_count = 0;
+    for (int lane = 0; lane < chart_lane_count; lane++) {
+        TimeSeries* s = &lane_queue_series[lane];
+        int cell_x = panel.x + half + (lane % columns) * cell_w + 2;
+        int cell_bottom = panel.y + (lane / columns + 1) * cell_h - 2;
+        int bar_h_max = cell_h - (chart_lane_labels() ? 20 : 4);
+        int first = s->count > bars ? s->count - bars : 0;
+        for (int i = first; i < s->count; i++) {
+            int h = (int)(series_at(s, i) / lane_max * bar_h_max);
+            if (h <= 0) continue;
+            SDL_Rect bar = {cell_x + (i - first), cell_bottom - h, 1, h};
+            lane_bars[lane_bar_count++] = bar;
+        }
+    }
+}
+
+void sample_charts() {
+    if (lane_queue_series == NULL) return;
+
+    Uint32 now = sim_ticks();
+    if (now < next_chart_sample) return;
+    next_chart_sample = now + chart_sample_ms;
+
+    // Each open member of a shared line shows its share of the line; the
+    // store total counts the line once.
+    int queued = 0;
+    for (int lane = 0; lane < chart_lane_count; lane++) {
+        Queue* q = lane_queue(lane);
+        pthread_mutex_lock(&q->lock);
+        int length = q->size;
+        pthread_mutex_unlock(&q->lock);
+        float share = 0.0f;
+        SharedLine* line = all_lanes[lane].line;
+        if (line != NULL && all_lanes[lane].status == LANE_OPEN) {
+            share = (float)shared_line_length(line) / shared_line_servers(line);
+        }
+        series_push(&lane_queue_series[lane], length + share);
+        queued += length;
+    }
+    for (int l = 0; l < shared_line_count; l++) queued += shared_line_length(&shared_lines[l]);
+    series_push(&store_queue_series, (float)queued);
+
+    int served = customers_served;
+    series_push(&throughput_series, (served - last_served_sample) * 60000.0f / chart_sample_ms);
+    last_served_sample = served;
+
+    build_chart_geometry();
+    if (charts_visible) view_dirty = true;
+}
+
+void draw_charts() {
+    if (!charts_visible || lane_queue_series == NULL) return;
+
+    Uint64 start = SDL_GetPerformanceCounter();
+    SDL_Rect panel = chart_panel_rect();
+    SDL_Color text = {40, 40, 40, 255};
+
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+    SDL_SetRenderDrawColor(renderer, 245, 245, 250, 230);
+    SDL_RenderFillRect(renderer, &panel);
+    SDL_SetRenderDrawColor(renderer, 180, 180, 190, 255);
+    SDL_RenderDrawRect(renderer, &panel);
+
+    SDL_SetRenderDrawColor(renderer, 200, 60, 60, 255);
+    if (queue_line_count > 1) SDL_RenderDrawLines(renderer, queue_line, queue_line_count);
+    SDL_SetRenderDrawColor(renderer, 40, 130, 60, 255);
+    if (throughput_line_count > 1) SDL_RenderDrawLines(renderer, throughput_line, throughput_line_count);
+    SDL_SetRenderDrawColor(renderer, 60, 90, 200, 255);
+    if (lane_bar_count > 0) SDL_RenderFillRects(renderer, lane_bars, lane_bar_count);
+
+    char buffer[64];
+    float queued = store_queue_series.count > 0 ? series_at(&store_queue_series, store_queue_series.count - 1) : 0;
+    float rate = throughput_series.count > 0 ? series_at(&throughput_series, throughput_series.count - 1) : 0;
+    snprintf(buffer, sizeof(buffer), "Queued: %.0f", queued);
+    draw_cached_label(&queue_label, buffer, panel.x + 5, panel.y + 3, text);
+    snprintf(buffer, sizeof(buffer), "Served/min: %.0f", rate);
+    draw_cached_label(&throughput_label, buffer, panel.x + 5, panel.y + panel.h / 2 + 3, text);
+
+    if (chart_lane_labels()) {
+        int columns = chart_lane_count < CHART_LANE_COLUMNS ? chart_lane_count : CHART_LANE_COLUMNS;
+        int rows = (chart_lane_count + columns - 1) / columns;
+        int half = panel.w / 2;
+        int cell_w = (panel.w - half) / columns;
+        int cell_h = panel.h / rows;
+        for (int lane = 0; lane < chart_lane_count; lane++) {
+            if (lane < cashier_count) snprintf(buffer, sizeof(buffer), "C%d", lane + 1);
+            else snprintf(buffer, sizeof(buffer), "K%d", lane - cashier_count + 1);
+            draw_cached_label(&lane_labels[lane], buffer, panel.x + half + (lane % columns) * cell_w + 2,
+                              panel.y + (lane / columns) * cell_h + 2, text);
+        }
+    }
+
+    chart_draw_ticks += SDL_GetPerformanceCounter() - start;
+    chart_frames++;
+}
+
+void free_charts() {
+    if (lane_queue_series == NULL) return;
+
+    if (chart_frames > 0) {
+        printf("Charts: %.0f us per frame over %d frames\n",
+               chart_draw_ticks * 1000000.0 / SDL_GetPerformanceFrequency() / chart_frames, chart_frames);
+    }
+    free_cached_label(&queue_label);
+    free_cached_label(&throughput_label);
+    for (int lane = 0; lane < chart_lane_count; lane++) free_cached_label(&lane_labels[lane]);
+    free(lane_labels);
+    free(lane_queue_series);
+    free(lane_bars);
+    lane_labels = NULL;
+    lane_queue_series = NULL;
+    lane_bars = NULL;
+}
@@ -0,0 +1,141 @@
+#include "structs.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <time.h>
+
+#define CLOCK_PAUSED_POLL_MS 100
+
+const float clock_presets[] = {1.0f, 10.0f, 100.0f};
+
+pthread_mutex_t clock_lock = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t clock_changed = PTHREAD_COND_INITIALIZER;
+float clock_speed = 1.0f;
+bool clock_paused = false;
+double clock_base_real = 0.0;
+double clock_base_sim = 0.0;
+
+// Wall time is only read here. Frame pacing uses real_ticks(); everything
+// else runs on sim_ticks(), which is built on the sub-millisecond real_ms() so
+// 100x does not advance in 100 ms steps.
+Uint32 real_ticks() {
+    return SDL_GetTicks();
+}
+
+double real_ms() {
+    return SDL_GetPerformanceCounter() * 1000.0 / SDL_GetPerformanceFrequency();
+}
+
+struct timespec deadline_after_ms(double ms) {
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    long long ns = (long long)(ms * 1000000.0);
+    deadline.tv_sec += ns / 1000000000LL;
+    deadline.tv_nsec += (long)(ns % 1000000000LL);
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+    return deadline;
+}
+
+double sim_now_locked() {
+    if (clock_paused) return clock_base_sim;
+    return clock_base_sim + (real_ms() - clock_base_real) * clock_speed;
+}
+
+// Simulated time starts level with wall time, so runs at 1x read the same
+// ticks as before.
+void init_clock() {
+    pthread_mutex_lock(&clock_lock);
+    clock_base_real = real_ms();
+    clock_base_sim = real_ticks();
+    clock_speed = time_scale;
+    clock_paused = false;
+    pthread_mutex_unlock(&clock_lock);
+}
+
+Uint32 sim_ticks() {
+    pthread_mutex_lock(&clock_lock);
+    double now = sim_now_locked();
+    pthread_mutex_unlock(&clock_lock);
+    return (Uint32)now;
+}
+
+// Wall milliseconds covering sim_ms of simulated time. While paused, callers
+// that poll keep their usual cadence.
+Uint32 clock_real_ms(Uint32 sim_ms) {
+    pthread_mutex_lock(&clock_lock);
+    Uint32 wall_ms = clock_paused ? sim_ms : (Uint32)(sim_ms / clock_speed);
+    pthread_mutex_unlock(&clock_lock);
+    return wall_ms > 0 || sim_ms == 0 ? wall_ms : 1;
+}
+
+// Wakes early if the speed changes or the run stops.
+void sim_sleep_ms(Uint32 ms) {
+    pthread_mutex_lock(&clock_lock);
+    double until = sim_now_locked() + ms;
+    while (simulation_running) {
+        double now = sim_now_locked();
+        if (now >= until) break;
+        double wall_ms = clock_paused ? CLOCK_PAUSED_POLL_MS : (until - now) / clock_speed;
+        struct timespec deadline = deadline_after_ms(wall_ms);
+        pthread_cond_timedwait(&clock_changed, &clock_lock, &deadline);
+    }
+    pthread_mutex_unlock(&clock_lock);
+}
+
+void clock_rebase_locked() {
+    clock_base_sim = sim_now_locked();
+    clock_base_real = real_ms();
+}
+
+void clock_set_speed(float speed) {
+    pthread_mutex_lock(&clock_lock);
+    clock_rebase_locked();
+    clock_speed = speed;
+    pthread_cond_broadcast(&clock_changed);
+    pthread_mutex_unlock(&clock_lock);
+}
+
+void clock_toggle_pause() {
+    pthread_mutex_lock(&clock_lock);
+    clock_rebase_locked();
+    clock_paused = !clock_paused;
+    pthread_cond_broadcast(&clock_changed);
+    pthread_mutex_unlock(&clock_lock);
+}
+
+void clock_wake_all() {
+    pthread_mutex_lock(&clock_lock);
+    pthread_cond_broadcast(&clock_changed);
+    pthread_mutex_unlock(&clock_lock);
+}
+
+bool clock_is_paused() {
+    pthread_mutex_lock(&clock_lock);
+    bool paused = clock_paused;
+    pthread_mutex_unlock(&clock_lock);
+    return paused;
+}
+
+void format_clock_speed(char* buffer, size_t size) {
+    pthread_mutex_lock(&clock_lock);
+    if (clock_paused) snprintf(buffer, size, "paused");
+    else snprintf(buffer, size, "%gx", clock_speed);
+    pthread_mutex_unlock(&clock_lock);
+}
+
+// 1, 2 and 3 pick 1x, 10x and 100x; space pauses and resumes.
+bool clock_handle_event(SDL_Event* event) {
+    if (event->type != SDL_KEYDOWN) return false;
+    SDL_Keycode key = event->key.keysym.sym;
+    if (key == SDLK_SPACE) {
+        clock_toggle_pause();
+        return true;
+    }
+    if (key >= SDLK_1 && key <= SDLK_3) {
+        clock_set_speed(clock_presets[key - SDLK_1]);
+        return true;
+    }
+    return false;
+}
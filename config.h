@@ -0,0 +1,391 @@
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#define MAX_OPTION_NAMES 128
+#define MAX_CONFIGURED_LANES 256
+
+uint64_t simulation_seed = 0;
+int replication_id = 0;
+bool work_stealing_enabled = false;
+int steal_min_queue = 2;
+int steal_poll_ms = 100;
+bool jockeying_enabled = false;
+int jockey_interval_ms = 2000;
+float jockey_threshold = 3.0f;
+bool autoscale_enabled = false;
+int autoscale_min_cashiers = 1;
+float autoscale_open_wait = 30.0f;
+float autoscale_close_wait = 10.0f;
+int autoscale_interval_ms = 1000;
+int autoscale_cooldown_ms = 5000;
+float wait_slo = 60.0f;
+bool learn_service_rates = false;
+float cashier_speed_prior = 1.0f;
+float kiosk_speed_prior = 1.0f;
+float service_prior_items = 10.0f;
+float service_ewma_rate = 0.05f;
+float service_time_noise = 0.0f;
+const char* routing_policy_name = "least_work";
+int routing_choices = 2;
+int kiosk_item_threshold = 8;
+int option_cashiers = 0;
+int option_kiosks = -1;
+int option_customers = 0;
+int store_count = 0;
+int shard_threads = 0;
+bool scaling_test = false;
+int stores_per_region = 1;
+int worker_processes = 0;
+double window_seconds = 60.0;
+const char* arrival_mode = "uniform";
+const char* arrival_rate_curve = NULL;
+float arrival_rate_scale = 1.0f;
+float day_start_hour = 0.0f;
+float arrival_horizon_hours = 24.0f;
+const char* cart_distribution = "uniform";
+float cart_log_mean = 2.0f;
+float cart_log_sigma = 0.8f;
+int max_cart_items = 60;
+const char* cart_weights = NULL;
+int arrival_bench_stores = 0;
+int express_lanes = 0;
+int express_item_limit = 10;
+int kiosk_item_limit = 0;
+bool express_compare = false;
+bool estimate_only = false;
+bool estimate_validate = false;
+bool optimize_staffing = false;
+float slo_p95_seconds = 60.0f;
+int max_search_cashiers = 16;
+int max_search_kiosks = 8;
+float cashier_cost = 1.0f;
+float kiosk_cost = 0.5f;
+int max_replications = 10;
+float ci_precision = 0.05f;
+float warmup_seconds = 0.0f;
+const char* snapshot_path = NULL;
+float snapshot_at = 0.0f;
+const char* restore_path = NULL;
+int snapshot_branches = 1;
+bool headless_mode = false;
+float sim_duration = 0.0f;
+int arrival_gap_min_ms = 1000;
+int arrival_gap_max_ms = 2999;
+float kiosk_speed = 0.8f;
+float cashier_speeds[MAX_CONFIGURED_LANES];
+int cashier_speed_count = 0;
+bool telemetry_enabled = false;
+const char* telemetry_name = "/checkout_telemetry";
+int telemetry_interval_ms = 250;
+const char* report_csv_path = NULL;
+const char* report_json_path = NULL;
+bool charts_visible = false;
+int chart_sample_ms = 500;
+int lane_capacity = 0;
+float patience_mean = 0.0f;
+const char* priority_mix_list = NULL;
+float time_scale = 1.0f;
+const char* shared_queue_name = "off";
+bool shared_queue_compare = false;
+int dispatch_workers = 32;
+
+const char* known_option_names[MAX_OPTION_NAMES];
+int known_option_count = 0;
+char* override_names[MAX_OPTION_NAMES];
+int override_count = 0;
+
+int parse_float_list(const char* text, float* out, int max) {
+    int count = 0;
+    const char* p = text;
+    while (p && *p && count < max) {
+        char* end;
+        float value = strtof(p, &end);
+        if (end == p) break;
+        out[count++] = value;
+        p = (*end == ',') ? end + 1 : NULL;
+    }
+    return count;
+}
+
+// Every option is read through here, so names given on the command line or in
+// a scenario file can be checked against the ones the program knows.
+const char* env_lookup(const char* name) {
+    bool seen = false;
+    for (int i = 0; i < known_option_count && !seen; i++) {
+        seen = strcmp(known_option_names[i], name) == 0;
+    }
+    if (!seen && known_option_count < MAX_OPTION_NAMES) known_option_names[known_option_count++] = name;
+    return getenv(name);
+}
+
+long long env_ll(const char* name, long long fallback) {
+    const char* value = env_lookup(name);
+    if (!value || !*value) return fallback;
+    return strtoll(value, NULL, 10);
+}
+
+int env_int(const char* name, int fallback) {
+    return (int)env_ll(name, fallback);
+}
+
+float env_float(const char* name, float fallback) {
+    const char* value = env_lookup(name);
+    if (!value || !*value) return fallback;
+    return strtof(value, NULL);
+}
+
+const char* env_string(const char* name, const char* fallback) {
+    const char* value = env_lookup(name);
+    if (!value || !*value) return fallback;
+    return value;
+}
+
+bool env_flag(const char* name, bool fallback) {
+    const char* value = env_lookup(name);
+    if (!value || !*value) return fallback;
+    return !(value[0] == '0' || value[0] == 'n' || value[0] == 'N' || value[0] == 'f' || value[0] == 'F');
+}
+
+void load_env_options() {
+    simulation_seed = (uint64_t)env_ll("CHECKOUT_SEED", (long long)time(NULL));
+    replication_id = env_int("CHECKOUT_REPLICATION", 0);
+    work_stealing_enabled = env_flag("CHECKOUT_WORK_STEALING", false);
+    steal_min_queue = env_int("CHECKOUT_STEAL_MIN_QUEUE", 2);
+    if (steal_min_queue < 1) steal_min_queue = 1;
+    jockeying_enabled = env_flag("CHECKOUT_JOCKEYING", false);
+    jockey_interval_ms = env_int("CHECKOUT_JOCKEY_INTERVAL_MS", 2000);
+    jockey_threshold = env_float("CHECKOUT_JOCKEY_THRESHOLD", 3.0f);
+    autoscale_enabled = env_flag("CHECKOUT_AUTOSCALE", false);
+    autoscale_min_cashiers = env_int("CHECKOUT_MIN_CASHIERS", 1);
+    if (autoscale_min_cashiers < 1) autoscale_min_cashiers = 1;
+    autoscale_open_wait = env_float("CHECKOUT_OPEN_WAIT", 30.0f);
+    autoscale_close_wait = env_float("CHECKOUT_CLOSE_WAIT", 10.0f);
+    if (autoscale_close_wait > autoscale_open_wait) autoscale_close_wait = autoscale_open_wait;
+    autoscale_interval_ms = env_int("CHECKOUT_AUTOSCALE_INTERVAL_MS", 1000);
+    autoscale_cooldown_ms = env_int("CHECKOUT_AUTOSCALE_COOLDOWN_MS", 5000);
+    wait_slo = env_float("CHECKOUT_WAIT_SLO", 60.0f);
+    learn_service_rates = env_flag("CHECKOUT_LEARN_RATES", false);
+    cashier_speed_prior = env_float("CHECKOUT_CASHIER_PRIOR", 1.0f);
+    kiosk_speed_prior = env_float("CHECKOUT_KIOSK_PRIOR", 1.0f);
+    service_prior_items = env_float("CHECKOUT_PRIOR_ITEMS", 10.0f);
+    service_ewma_rate = env_float("CHECKOUT_EWMA_RATE", 0.05f);
+    service_time_noise = env_float("CHECKOUT_SERVICE_NOISE", 0.0f);
+    routing_policy_name = env_string("CHECKOUT_ROUTING", "least_work");
+    routing_choices = env_int("CHECKOUT_ROUTING_CHOICES", 2);
+    if (routing_choices < 1) routing_choices = 1;
+    kiosk_item_threshold = env_int("CHECKOUT_KIOSK_ITEM_THRESHOLD", 8);
+    option_cashiers = env_int("CHECKOUT_CASHIERS", 0);
+    option_kiosks = env_int("CHECKOUT_KIOSKS", -1);
+    option_customers = env_int("CHECKOUT_CUSTOMERS", 0);
+    store_count = env_int("CHECKOUT_STORES", 0);
+    shard_threads = env_int("CHECKOUT_THREADS", 0);
+    scaling_test = env_flag("CHECKOUT_SCALING", false);
+    stores_per_region = env_int("CHECKOUT_REGION_SIZE", 1);
+    if (stores_per_region < 1) stores_per_region = 1;
+    worker_processes = env_int("CHECKOUT_PROCESSES", 0);
+    window_seconds = env_float("CHECKOUT_WINDOW_SECONDS", 60.0f);
+    if (window_seconds <= 0) window_seconds = 60.0;
+    arrival_mode = env_string("CHECKOUT_ARRIVALS", "uniform");
+    arrival_rate_curve = env_string("CHECKOUT_RATE_CURVE", NULL);
+    arrival_rate_scale = env_float("CHECKOUT_RATE_SCALE", 1.0f);
+    day_start_hour = env_float("CHECKOUT_DAY_START", 0.0f);
+    arrival_horizon_hours = env_float("CHECKOUT_HORIZON_HOURS", 24.0f);
+    cart_distribution = env_string("CHECKOUT_CARTS", "uniform");
+    cart_log_mean = env_float("CHECKOUT_CART_LOG_MEAN", 2.0f);
+    cart_log_sigma = env_float("CHECKOUT_CART_LOG_SIGMA", 0.8f);
+    if (cart_log_sigma <= 0) cart_log_sigma = 0.8f;
+    max_cart_items = env_int("CHECKOUT_MAX_CART", 60);
+    if (max_cart_items < 1) max_cart_items = 1;
+    cart_weights = env_string("CHECKOUT_CART_WEIGHTS", NULL);
+    arrival_bench_stores = env_int("CHECKOUT_ARRIVAL_BENCH", 0);
+    express_lanes = env_int("CHECKOUT_EXPRESS_LANES", 0);
+    if (express_lanes < 0) express_lanes = 0;
+    express_item_limit = env_int("CHECKOUT_EXPRESS_LIMIT", 10);
+    if (express_item_limit < 1) express_item_limit = 1;
+    kiosk_item_limit = env_int("CHECKOUT_KIOSK_LIMIT", 0);
+    if (kiosk_item_limit < 0) kiosk_item_limit = 0;
+    express_compare = env_flag("CHECKOUT_EXPRESS_COMPARE", false);
+    estimate_only = env_flag("CHECKOUT_ESTIMATE", false);
+    estimate_validate = env_flag("CHECKOUT_ESTIMATE_VALIDATE", false);
+    optimize_staffing = env_flag("CHECKOUT_OPTIMIZE", false);
+    slo_p95_seconds = env_float("CHECKOUT_SLO_P95", 60.0f);
+    if (slo_p95_seconds <= 0) slo_p95_seconds = 60.0f;
+    max_search_cashiers = env_int("CHECKOUT_MAX_CASHIERS", 16);
+    if (max_search_cashiers < 1) max_search_cashiers = 1;
+    max_search_kiosks = env_int("CHECKOUT_MAX_KIOSKS", 8);
+    if (max_search_kiosks < 0) max_search_kiosks = 0;
+    cashier_cost = env_float("CHECKOUT_CASHIER_COST", 1.0f);
+    if (cashier_cost <= 0) cashier_cost = 1.0f;
+    kiosk_cost = env_float("CHECKOUT_KIOSK_COST", 0.5f);
+    if (kiosk_cost <= 0) kiosk_cost = 0.5f;
+    max_replications = env_int("CHECKOUT_MAX_REPLICATIONS", 10);
+    if (max_replications < 2) max_replications = 2;
+    ci_precision = env_float("CHECKOUT_CI_PRECISION", 0.05f);
+    if (ci_precision <= 0) ci_precision = 0.05f;
+    warmup_seconds = env_float("CHECKOUT_WARMUP", 0.0f);
+    if (warmup_seconds < 0) warmup_seconds = 0.0f;
+    snapshot_path = env_string("CHECKOUT_SNAPSHOT", NULL);
+    snapshot_at = env_float("CHECKOUT_SNAPSHOT_AT", 0.0f);
+    restore_path = env_string("CHECKOUT_RESTORE", NULL);
+    snapshot_branches = env_int("CHECKOUT_BRANCHES", 1);
+    if (snapshot_branches < 1) snapshot_branches = 1;
+    headless_mode = env_flag("CHECKOUT_HEADLESS", false);
+    sim_duration = env_float("CHECKOUT_DURATION", 0.0f);
+    arrival_gap_min_ms = env_int("CHECKOUT_ARRIVAL_MIN_MS", 1000);
+    if (arrival_gap_min_ms < 0) arrival_gap_min_ms = 0;
+    arrival_gap_max_ms = env_int("CHECKOUT_ARRIVAL_MAX_MS", 2999);
+    if (arrival_gap_max_ms < arrival_gap_min_ms) arrival_gap_max_ms = arrival_gap_min_ms;
+    kiosk_speed = env_float("CHECKOUT_KIOSK_SPEED", 0.8f);
+    if (kiosk_speed <= 0) kiosk_speed = 0.8f;
+    telemetry_enabled = env_flag("CHECKOUT_TELEMETRY", false);
+    telemetry_name = env_string("CHECKOUT_TELEMETRY_NAME", "/checkout_telemetry");
+    telemetry_interval_ms = env_int("CHECKOUT_TELEMETRY_INTERVAL_MS", 250);
+    if (telemetry_interval_ms < 10) telemetry_interval_ms = 10;
+    report_csv_path = env_string("CHECKOUT_REPORT_CSV", NULL);
+    report_json_path = env_string("CHECKOUT_REPORT_JSON", NULL);
+    charts_visible = env_flag("CHECKOUT_CHARTS", false);
+    chart_sample_ms = env_int("CHECKOUT_CHART_SAMPLE_MS", 500);
+    if (chart_sample_ms < 50) chart_sample_ms = 50;
+    lane_capacity = env_int("CHECKOUT_LANE_CAPACITY", 0);
+    if (lane_capacity < 0) lane_capacity = 0;
+    patience_mean = env_float("CHECKOUT_PATIENCE", 0.0f);
+    if (patience_mean < 0) patience_mean = 0.0f;
+    priority_mix_list = env_string("CHECKOUT_PRIORITY_MIX", NULL);
+    time_scale = env_float("CHECKOUT_TIME_SCALE", 1.0f);
+    if (time_scale <= 0) time_scale = 1.0f;
+    shared_queue_name = env_string("CHECKOUT_SHARED_QUEUE", "off");
+    shared_queue_compare = env_flag("CHECKOUT_SHARED_QUEUE_COMPARE", false);
+    dispatch_workers = env_int("CHECKOUT_DISPATCH_WORKERS", 32);
+    if (dispatch_workers < 1) dispatch_workers = 1;
+    cashier_speed_count = parse_float_list(env_string("CHECKOUT_CASHIER_SPEEDS", NULL), cashier_speeds, MAX_CONFIGURED_LANES);
+}
+
+// "cashier-speeds" and "CHECKOUT_CASHIER_SPEEDS" name the same option.
+void option_env_name(const char* key, char* out, size_t size) {
+    size_t n = 0;
+    if (strncmp(key, "CHECKOUT_", 9) != 0) {
+        n = snprintf(out, size, "CHECKOUT_");
+    }
+    for (; *key && n + 1 < size; key++) {
+        out[n++] = *key == '-' ? '_' : (char)toupper((unsigned char)*key);
+    }
+    out[n] = '\0';
+}
+
+void set_option(const char* key, const char* value) {
+    char name[64];
+    option_env_name(key, name, sizeof(name));
+    setenv(name, value, 1);
+    if (override_count < MAX_OPTION_NAMES) override_names[override_count++] = strdup(name);
+}
+
+char* trim(char* text) {
+    while (isspace((unsigned char)*text)) text++;
+    char* end = text + strlen(text);
+    while (end > text && isspace((unsigned char)end[-1])) *--end = '\0';
+    return text;
+}
+
+// One "key = value" per line; blank lines and anything after '#' are ignored.
+bool load_scenario_file(const char* path) {
+    FILE* f = fopen(path, "r");
+    if (f == NULL) {
+        perror(path);
+        return false;
+    }
+
+    char line[512];
+    int number = 0;
+    bool ok = true;
+    while (fgets(line, sizeof(line), f) != NULL) {
+        number++;
+        char* comment = strchr(line, '#');
+        if (comment != NULL) *comment = '\0';
+        char* text = trim(line);
+        if (*text == '\0') continue;
+
+        char* split = strpbrk(text, "= \t");
+        if (split == NULL) {
+            printf("%s:%d: expected 'key = value'\n", path, number);
+            ok = false;
+            continue;
+        }
+        char* value = split + strspn(split, "= \t");
+        *split = '\0';
+        set_option(trim(text), trim(value));
+    }
+    fclose(f);
+    return ok;
+}
+
+void print_usage(const char* program) {
+    printf("Usage: %s [--scenario FILE] [--option value ...]\n\n", program);
+    printf("Every CHECKOUT_* environment variable can also be given as a flag (CHECKOUT_KIOSK_SPEED is\n");
+    printf("--kiosk-speed) or as a 'kiosk-speed = 0.7' line in a scenario file. Flags override the\n");
+    printf("scenario file, which overrides the environment. Common options:\n\n");
+    printf("  --cashiers N --kiosks N --customers N   lane and customer counts (skip the prompts)\n");
+    printf("  --cashier-speeds 0.6,1.1,...            seconds per item for the first cashiers\n");
+    printf("  --kiosk-speed S                         seconds per item at every kiosk (default 0.8)\n");
+    printf("  --arrival-min-ms N --arrival-max-ms N   uniform gap between arrivals (default 1000-2999)\n");
+    printf("  --arrivals nhpp --rate-scale X          time-of-day arrivals\n");
+    printf("  --seed N --replication N                random streams\n");
+    printf("  --duration S                            stop after S simulated seconds\n");
+    printf("  --headless                              no window; same as --stores 1 if no store count is set\n");
+}
+
+// Returns 1 to run, 0 when only help was requested and -1 on a bad option.
+int load_options(int argc, char* argv[]) {
+    const char* scenario = getenv("CHECKOUT_SCENARIO");
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--scenario") == 0 && i + 1 < argc) scenario = argv[i + 1];
+        else if (strncmp(argv[i], "--scenario=", 11) == 0) scenario = argv[i] + 11;
+    }
+    if (scenario != NULL && *scenario && !load_scenario_file(scenario)) return -1;
+
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        if (strcmp(arg, "--help") == 0 || strcmp(arg, "-h") == 0) {
+            print_usage(argv[0]);
+            return 0;
+        }
+        if (strncmp(arg, "--", 2) != 0) {
+            printf("Unexpected argument '%s' (see --help)\n", arg);
+            return -1;
+        }
+        if (strcmp(arg, "--scenario") == 0) {
+            i++;
+            continue;
+        }
+        if (strncmp(arg, "--scenario=", 11) == 0) continue;
+
+        char key[64];
+        const char* value;
+        const char* equals = strchr(arg, '=');
+        if (equals != NULL) {
+            snprintf(key, sizeof(key), "%.*s", (int)(equals - arg - 2), arg + 2);
+            value = equals + 1;
+        } else {
+            snprintf(key, sizeof(key), "%s", arg + 2);
+            value = (i + 1 < argc && strncmp(argv[i + 1], "--", 2) != 0) ? argv[++i] : "1";
+        }
+        set_option(key, value);
+    }
+
+    load_env_options();
+
+    for (int i = 0; i < override_count; i++) {
+        bool known = false;
+        for (int k = 0; k < known_option_count && !known; k++) {
+            known = strcmp(known_option_names[k], override_names[i]) == 0;
+        }
+        if (!known) {
+            printf("Unknown option %s (see --help)\n", override_names[i]);
+            return -1;
+        }
+    }
+    return 1;
+}
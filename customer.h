@@ -1,4 +1,5 @@
 #include "structs.h"
+#include <math.h>
 #include <pthread.h>
 
 #define SCREEN_WIDTH 1200
@@ -23,54 +24,65 @@ bool simulation_running = false;
 Uint32 simulation_start_time = 0;
 Uint32 simulation_end_time = 0;
 
-Customer* create_customer(int id) {
-    Customer* c = (Customer*)malloc(sizeof(Customer));
+Customer* create_customer(int id, int items) {
+    Customer* c = pool_acquire(&customer_pool);
     c->id = id;
-    c->service_time = (rand() % 5) + 3; 
-    c->items = (rand() % 15) + 1;        
+    c->items = items;        
     c->visual_state = WAITING_TO_ENTER;
     
-    c->x = SCREEN_WIDTH / 2 + (rand() % 200 - 100);
-    c->y = SCREEN_HEIGHT + (rand() % 50);
+    c->x = SCREEN_WIDTH / 2 + rng_range(&customer_rng, -100, 99);
+    c->y = SCREEN_HEIGHT + rng_range(&customer_rng, 0, 49);
     
     c->target_x = c->x;
     c->target_y = c->y;
-    c->cashier_id = -1;
-    c->kiosk_id = -1;
+    c->lane_id = 0;
     c->service_start_time = 0;
     c->is_active = true;
-    c->has_reached_cashier = false;
-    c->has_reached_kiosk = false;
+    c->reached_lane = false;
+    c->ring_pinned = false;
+    c->priority = draw_priority_class(&class_rng);
+    c->line_id = 0;
+    c->claimed = 0;
     
     return c;
 }
 
 
-void update_customers() {
+Uint32 last_customer_update = 0;
+
+float step_toward(float from, float to, float step) {
+    if (fabsf(to - from) <= step) return to;
+    return from < to ? from + step : from - step;
+}
+
+// Returns true while any customer is still moving, so the caller knows to
+// keep animating. Walking speed follows the simulation clock, so customers
+// hurry at 10x and stand still while paused.
+bool update_customers() {
+    bool moved = false;
+    Uint32 now = sim_ticks();
+    float step = last_customer_update > 0 ? CUSTOMER_SPEED * (float)(now - last_customer_update) / FRAME_MS : CUSTOMER_SPEED;
+    last_customer_update = now;
+    if (step <= 0) return false;
     pthread_mutex_lock(&visualization_lock);
     
-    for (int i = 0; i < total_customers; i++) {
-        Customer* c = all_customers[i];
+    for (int i = 0; i < customer_pool.in_store_count; i++) {
+        Customer* c = customer_pool.in_store[i];
         if (!c->is_active) continue;
         
+        float old_x = c->x;
+        float old_y = c->y;
+        CustomerVisualState old_state = c->visual_state;
+        Lane* lane = customer_lane(c);
+        
         switch (c->visual_state) {
             case WAITING_TO_ENTER:
                 c->visual_state = MOVING_TO_QUEUE;
                 break;
                 
             case MOVING_TO_QUEUE:
-                if (c->y > c->target_y) {
-                    c->y -= CUSTOMER_SPEED;
-                } else if (c->y < c->target_y) {
-                    c->y += CUSTOMER_SPEED;
-                }
-                
-                if (abs(c->x - c->target_x) > CUSTOMER_SPEED) {
-                    if (c->x < c->target_x) c->x += CUSTOMER_SPEED;
-                    else c->x -= CUSTOMER_SPEED;
-                } else {
-                    c->x = c->target_x;
-                }
+                c->y = step_toward(c->y, c->target_y, step);
+                c->x = step_toward(c->x, c->target_x, step);
                 
                 if (abs(c->x - c->target_x) <= CUSTOMER_SPEED && 
                     abs(c->y - c->target_y) <= CUSTOMER_SPEED) {
@@ -81,44 +93,42 @@ void update_customers() {
                 break;
                 
             case QUEUED:
-                if (c->cashier_id > 0 && c->cashier_id <= cashier_count) {
-                    Cashier* cashier = all_cashiers[c->cashier_id - 1];
-                    
+                if (lane != NULL) {
                     int position_in_queue = 0;
-                    for (int j = 0; j < total_customers; j++) {
-                        if (all_customers[j]->is_active && 
-                            all_customers[j]->cashier_id == c->cashier_id &&
-                            all_customers[j]->visual_state == QUEUED &&
-                            all_customers[j]->id < c->id) {
+                    for (int j = 0; j < customer_pool.in_store_count; j++) {
+                        Customer* other = customer_pool.in_store[j];
+                        if (other->is_active && 
+                            customer_in_lane(other, lane) &&
+                            other->visual_state == QUEUED &&
+                            other->id < c->id) {
                             position_in_queue++;
                         }
                     }
                     
-                    float new_target_x = cashier->x;
-                    float new_target_y = cashier->y + TABLE_HEIGHT/2 + 20 + (position_in_queue * CUSTOMER_SIZE);
+                    float new_target_x, new_target_y;
+                    lane_queue_slot(lane, position_in_queue, &new_target_x, &new_target_y);
                     
-                    if (abs(new_target_y - c->target_y) > 5) {
+                    if (abs(new_target_x - c->target_x) > 5 || abs(new_target_y - c->target_y) > 5) {
                         c->target_x = new_target_x;
                         c->target_y = new_target_y;
                         c->visual_state = MOVING_TO_QUEUE; 
                     }
-                } else if (c->kiosk_id > 0 && c->kiosk_id <= selfcheckout_count) {
-                    SelfCheckout* kiosk = all_kiosks[c->kiosk_id - 1];
-                    
+                } else if (c->line_id > 0) {
                     int position_in_queue = 0;
-                    for (int j = 0; j < total_customers; j++) {
-                        if (all_customers[j]->is_active && 
-                            all_customers[j]->kiosk_id == c->kiosk_id &&
-                            all_customers[j]->visual_state == QUEUED &&
-                            all_customers[j]->id < c->id) {
+                    for (int j = 0; j < customer_pool.in_store_count; j++) {
+                        Customer* other = customer_pool.in_store[j];
+                        if (other->is_active && 
+                            other->line_id == c->line_id &&
+                            other->visual_state == QUEUED &&
+                            other->id < c->id) {
                             position_in_queue++;
                         }
                     }
                     
-                    float new_target_x = SCREEN_WIDTH * 3/4 + 20 + (position_in_queue * CUSTOMER_SIZE);
-                    float new_target_y = kiosk->y;
+                    float new_target_x, new_target_y;
+                    shared_line_position(&shared_lines[c->line_id - 1], position_in_queue, &new_target_x, &new_target_y);
                     
-                    if (abs(new_target_x - c->target_x) > 5) {
+                    if (abs(new_target_x - c->target_x) > 5 || abs(new_target_y - c->target_y) > 5) {
                         c->target_x = new_target_x;
                         c->target_y = new_target_y;
                         c->visual_state = MOVING_TO_QUEUE; 
@@ -127,71 +137,26 @@ void update_customers() {
                 break;
                 
             case BEING_SERVED:
-                if (c->cashier_id > 0 && c->cashier_id <= cashier_count) {
-                    Cashier* cashier = all_cashiers[c->cashier_id - 1];
-                    
-                    float service_x = cashier->x;
-                    float service_y = cashier->y + (TABLE_HEIGHT/2) - 20; 
+                if (lane != NULL) {
+                    float service_x, service_y;
+                    lane_service_point(lane, &service_x, &service_y);
                     
                     if (abs(c->x - service_x) > 2 || abs(c->y - service_y) > 2) {
                         c->target_x = service_x;
                         c->target_y = service_y;
                         
-                        if (c->y > c->target_y) {
-                            c->y -= CUSTOMER_SPEED;
-                        } else if (c->y < c->target_y) {
-                            c->y += CUSTOMER_SPEED;
-                        }
-                        
-                        if (abs(c->x - c->target_x) > CUSTOMER_SPEED) {
-                            if (c->x < c->target_x) c->x += CUSTOMER_SPEED;
-                            else c->x -= CUSTOMER_SPEED;
-                        } else {
-                            c->x = c->target_x;
-                        }
+                        c->y = step_toward(c->y, c->target_y, step);
+                        c->x = step_toward(c->x, c->target_x, step);
                     } else {
                         c->x = service_x;
                         c->y = service_y;
-                        
-                        if (!c->has_reached_cashier) {
-                            c->has_reached_cashier = true;
-                        }
-                    }
-                } else if (c->kiosk_id > 0 && c->kiosk_id <= selfcheckout_count) {
-                    SelfCheckout* kiosk = all_kiosks[c->kiosk_id - 1];
-                    
-                    float service_x = kiosk->x;
-                    float service_y = kiosk->y;
-                    
-                    if (abs(c->x - service_x) > 2 || abs(c->y - service_y) > 2) {
-                        c->target_x = service_x;
-                        c->target_y = service_y;
-                        
-                        if (c->y > c->target_y) {
-                            c->y -= CUSTOMER_SPEED;
-                        } else if (c->y < c->target_y) {
-                            c->y += CUSTOMER_SPEED;
-                        }
-                        
-                        if (abs(c->x - c->target_x) > CUSTOMER_SPEED) {
-                            if (c->x < c->target_x) c->x += CUSTOMER_SPEED;
-                            else c->x -= CUSTOMER_SPEED;
-                        } else {
-                            c->x = c->target_x;
-                        }
-                    } else {
-                        c->x = service_x;
-                        c->y = service_y;
-                        
-                        if (!c->has_reached_kiosk) {
-                            c->has_reached_kiosk = true;
-                        }
+                        c->reached_lane = true;
                     }
                 }
                 break;
                 
             case LEAVING:
-                c->y -= CUSTOMER_SPEED * 1.5; 
+                c->y -= step * 1.5f;
                 if (c->y + CUSTOMER_SIZE < 0) {
                     c->visual_state = EXITED;
                     c->is_active = false;
@@ -201,7 +166,95 @@ void update_customers() {
             case EXITED:
                 break;
         }
+        
+        if (c->x != old_x || c->y != old_y || c->visual_state != old_state) moved = true;
+    }
+    
+    pool_sweep(&customer_pool);
+    pthread_mutex_unlock(&visualization_lock);
+    return moved;
+}
+
+void place_in_lane_queue(Customer* c, Lane* lane) {
+    int queuePosition = 0;
+    for (int j = 0; j < customer_pool.in_store_count; j++) {
+        Customer* other = customer_pool.in_store[j];
+        if (other->is_active && 
+            other->visual_state == QUEUED && 
+            customer_in_lane(other, lane)) {
+            queuePosition++;
+        }
     }
     
+    lane_queue_slot(lane, queuePosition, &c->target_x, &c->target_y);
+    c->lane_id = lane_index(lane) + 1;
+}
+
+void place_in_shared_line(Customer* c, SharedLine* line) {
+    int index = shared_line_index(line);
+    int queuePosition = 0;
+    for (int j = 0; j < customer_pool.in_store_count; j++) {
+        Customer* other = customer_pool.in_store[j];
+        if (other->is_active && 
+            other->visual_state == QUEUED && 
+            other->line_id == index + 1) {
+            queuePosition++;
+        }
+    }
+    
+    shared_line_position(line, queuePosition, &c->target_x, &c->target_y);
+    c->lane_id = 0;
+    c->line_id = index + 1;
+}
+
+void balk_customer(Customer* c) {
+    pthread_mutex_lock(&visualization_lock);
+    c->visual_state = EXITED;
+    c->is_active = false;
+    c->line_id = 0;
     pthread_mutex_unlock(&visualization_lock);
+    record_abandonment(false);
+}
+
+void route_customer(Customer* c) {
+    c->arrival_time = sim_ticks();
+    
+    Lane* lane = choose_checkout(c);
+    SharedLine* line = lane != NULL ? lane->line : NULL;
+    
+    // With no lane open that takes the cart, the customer balks.
+    bool full = lane == NULL;
+    if (lane != NULL && lane_capacity > 0) {
+        if (line != NULL) {
+            full = lane_full(shared_line_length(line) / line->members);
+        } else {
+            pthread_mutex_lock(&lane->queue->lock);
+            full = lane_full(lane->queue->size);
+            pthread_mutex_unlock(&lane->queue->lock);
+        }
+    }
+    if (full) {
+        balk_customer(c);
+        return;
+    }
+    
+    // A shared line's ring is sized for the customers the store can hold;
+    // one that is full turns the arrival away.
+    if (line != NULL) {
+        place_in_shared_line(c, line);
+        if (!shared_line_push(line, c)) {
+            balk_customer(c);
+            return;
+        }
+        schedule_patience(c);
+    } else {
+        place_in_lane_queue(c, lane);
+        enqueue(lane->queue, c);
+        schedule_patience(c);
+    }
+    
+    if (world_width > SCREEN_WIDTH || world_height > SCREEN_HEIGHT) {
+        c->x = c->target_x;
+        c->y = c->target_y + CUSTOMER_SIZE * 2;
+    }
 }
\ No newline at end of file
@@ -0,0 +1,128 @@
+#include "structs.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <float.h>
+
+CustomerPool customer_pool;
+
+int arrival_cart_buffer[ARRIVAL_BATCH];
+int arrival_cart_next = ARRIVAL_BATCH;
+Uint32 arrival_gap_buffer[ARRIVAL_BATCH];
+double arrival_time_buffer[ARRIVAL_BATCH];
+int arrival_next = 0;
+int arrival_count = 0;
+int arrivals_scheduled = 0;
+double arrival_clock = 0.0;
+double last_arrival_seconds = 0.0;
+
+Customer* pool_customer(CustomerPool* p, uint32_t slot) {
+    return &p->chunks[slot / CUSTOMER_POOL_CHUNK][slot % CUSTOMER_POOL_CHUNK];
+}
+
+// Chunks never move, so customer pointers held by queues and lanes stay valid
+// as the pool grows.
+void pool_grow(CustomerPool* p) {
+    int slots = (p->chunk_count + 1) * CUSTOMER_POOL_CHUNK;
+    p->chunks = (Customer**)realloc(p->chunks, sizeof(Customer*) * (p->chunk_count + 1));
+    p->chunks[p->chunk_count] = (Customer*)calloc(CUSTOMER_POOL_CHUNK, sizeof(Customer));
+    p->free_slots = (uint32_t*)realloc(p->free_slots, sizeof(uint32_t) * slots);
+    p->in_store = (Customer**)realloc(p->in_store, sizeof(Customer*) * slots);
+    for (int i = slots - 1; i >= p->chunk_count * CUSTOMER_POOL_CHUNK; i--) {
+        p->free_slots[p->free_count++] = (uint32_t)i;
+    }
+    p->chunk_count++;
+}
+
+Customer* pool_acquire(CustomerPool* p) {
+    if (p->free_count == 0) pool_grow(p);
+    uint32_t slot = p->free_slots[--p->free_count];
+    Customer* c = pool_customer(p, slot);
+    c->slot = slot;
+    p->in_store[p->in_store_count++] = c;
+    if (p->in_store_count > p->peak_in_store) p->peak_in_store = p->in_store_count;
+    return c;
+}
+
+bool pool_releasable(Customer* c) {
+    if (c->is_active) return false;
+    return !c->ring_pinned || __atomic_load_n(&c->claimed, __ATOMIC_ACQUIRE) == CUSTOMER_RING_RELEASED;
+}
+
+// Called with visualization_lock held. Clearing the id makes patience timers
+// still pointing at the slot recognise it as gone.
+void pool_sweep(CustomerPool* p) {
+    int kept = 0;
+    for (int i = 0; i < p->in_store_count; i++) {
+        Customer* c = p->in_store[i];
+        if (pool_releasable(c)) {
+            c->id = 0;
+            p->free_slots[p->free_count++] = c->slot;
+            p->recycled++;
+        } else {
+            p->in_store[kept++] = c;
+        }
+    }
+    p->in_store_count = kept;
+}
+
+void pool_free(CustomerPool* p) {
+    for (int i = 0; i < p->chunk_count; i++) free(p->chunks[i]);
+    free(p->chunks);
+    free(p->free_slots);
+    free(p->in_store);
+    memset(p, 0, sizeof(CustomerPool));
+}
+
+int next_cart_size() {
+    if (arrival_cart_next >= ARRIVAL_BATCH) {
+        fill_cart_sizes(&customer_rng, arrival_cart_buffer, ARRIVAL_BATCH);
+        arrival_cart_next = 0;
+    }
+    return arrival_cart_buffer[arrival_cart_next++];
+}
+
+// Once a rate curve has no arrivals left, the run ends with the customers
+// already scheduled.
+void end_arrivals() {
+    pthread_mutex_lock(&customers_served_lock);
+    total_customers = arrivals_scheduled;
+    if (customers_served + customers_balked + customers_reneged >= total_customers) {
+        all_customers_served = 1;
+        simulation_end_time = sim_ticks();
+    }
+    pthread_mutex_unlock(&customers_served_lock);
+}
+
+// Gaps are drawn a batch at a time, the same way the headless stores do, and
+// the gap returned is the one before the next customer to arrive.
+bool next_arrival_gap(Uint32* gap) {
+    if (arrivals_scheduled >= total_customers) return false;
+    if (arrival_next >= arrival_count) {
+        arrival_next = 0;
+        if (uniform_arrivals()) {
+            rng_fill_gaps_ms(&arrival_rng, arrival_gap_buffer, ARRIVAL_BATCH, arrival_gap_min_ms, arrival_gap_max_ms);
+            arrival_count = ARRIVAL_BATCH;
+        } else {
+            arrival_count = generate_arrival_times(&arrival_curve, &arrival_rng, &arrival_clock, DBL_MAX,
+                                                   arrival_time_buffer, ARRIVAL_BATCH);
+            for (int i = 0; i < arrival_count; i++) {
+                arrival_gap_buffer[i] = (Uint32)((arrival_time_buffer[i] - last_arrival_seconds) * 1000.0);
+                last_arrival_seconds = arrival_time_buffer[i];
+            }
+        }
+        if (arrival_count == 0) {
+            end_arrivals();
+            return false;
+        }
+    }
+    *gap = arrival_gap_buffer[arrival_next++];
+    arrivals_scheduled++;
+    return true;
+}
+
+void print_customer_pool_summary() {
+    printf("Customer pool: peak %d in store, %d records allocated, %lld recycled\n",
+           customer_pool.peak_in_store, customer_pool.chunk_count * CUSTOMER_POOL_CHUNK, customer_pool.recycled);
+}
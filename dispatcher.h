@@ -0,0 +1,430 @@
+#include "structs.h"
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <semaphore.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SHARED_LINE_POLL_MS 100
+#define SHARED_LINE_DEPTH 256
+#define DISPATCH_BENCH_ITEMS (1 << 18)
+
+const char* shared_queue_names[] = {"off", "all", "cashiers", "kiosks", "split"};
+
+SharedQueueMode shared_queue_mode = SHARED_OFF;
+SharedLine shared_lines[MAX_SHARED_LINES];
+int shared_line_count = 0;
+
+void init_shared_queue_mode() {
+    int count = sizeof(shared_queue_names) / sizeof(shared_queue_names[0]);
+    for (int m = 0; m < count; m++) {
+        if (strcmp(shared_queue_names[m], shared_queue_name) == 0) {
+            shared_queue_mode = (SharedQueueMode)m;
+            return;
+        }
+    }
+    printf("Unknown shared queue mode '%s', using off\n", shared_queue_name);
+    shared_queue_mode = SHARED_OFF;
+}
+
+// -1 keeps the lane on its own queue.
+int shared_group(CheckoutType kind) {
+    switch (shared_queue_mode) {
+        case SHARED_ALL: return 0;
+        case SHARED_CASHIERS: return kind == CASHIER ? 0 : -1;
+        case SHARED_KIOSKS: return kind == KIOSK ? 0 : -1;
+        case SHARED_SPLIT: return kind == CASHIER ? 0 : 1;
+        default: return -1;
+    }
+}
+
+// Lanes of a group only share a line with lanes of the same item limit, so
+// express lanes get a line of their own and no lane is handed a cart it may
+// not take.
+int assign_shared_lines(const CheckoutType* kinds, const int* limits, int lanes, int* line_of) {
+    int groups[MAX_SHARED_LINES];
+    int group_limits[MAX_SHARED_LINES];
+    int count = 0;
+    for (int i = 0; i < lanes; i++) {
+        line_of[i] = -1;
+        int group = shared_group(kinds[i]);
+        if (group < 0) continue;
+
+        int l = 0;
+        while (l < count && (groups[l] != group || group_limits[l] != limits[i])) l++;
+        if (l == count) {
+            if (count == MAX_SHARED_LINES) continue;
+            groups[count] = group;
+            group_limits[count] = limits[i];
+            count++;
+        }
+        line_of[i] = l;
+    }
+    return count;
+}
+
+// Bounded multi-producer multi-consumer ring (Vyukov). Each cell's sequence
+// says whether it is ready for the producer or the consumer at a position, so
+// both sides only race on a single counter with a compare-and-swap.
+void mpmc_init(MpmcRing* r, int min_capacity) {
+    size_t capacity = 2;
+    while (capacity < (size_t)min_capacity) capacity *= 2;
+    r->cells = (MpmcCell*)malloc(sizeof(MpmcCell) * capacity);
+    for (size_t i = 0; i < capacity; i++) r->cells[i].sequence = i;
+    r->mask = capacity - 1;
+    r->enqueue_pos = 0;
+    r->dequeue_pos = 0;
+}
+
+void mpmc_free(MpmcRing* r) {
+    free(r->cells);
+    r->cells = NULL;
+}
+
+bool mpmc_push(MpmcRing* r, Customer* c) {
+    size_t pos = __atomic_load_n(&r->enqueue_pos, __ATOMIC_RELAXED);
+    while (true) {
+        MpmcCell* cell = &r->cells[pos & r->mask];
+        size_t sequence = __atomic_load_n(&cell->sequence, __ATOMIC_ACQUIRE);
+        intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+        if (diff == 0) {
+            if (__atomic_compare_exchange_n(&r->enqueue_pos, &pos, pos + 1, true,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                cell->data = c;
+                __atomic_store_n(&cell->sequence, pos + 1, __ATOMIC_RELEASE);
+                return true;
+            }
+        } else if (diff < 0) {
+            return false;
+        } else {
+            pos = __atomic_load_n(&r->enqueue_pos, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+Customer* mpmc_pop(MpmcRing* r) {
+    size_t pos = __atomic_load_n(&r->dequeue_pos, __ATOMIC_RELAXED);
+    while (true) {
+        MpmcCell* cell = &r->cells[pos & r->mask];
+        size_t sequence = __atomic_load_n(&cell->sequence, __ATOMIC_ACQUIRE);
+        intptr_t diff = (intptr_t)sequence - (intptr_t)(pos + 1);
+        if (diff == 0) {
+            if (__atomic_compare_exchange_n(&r->dequeue_pos, &pos, pos + 1, true,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                Customer* c = cell->data;
+                __atomic_store_n(&cell->sequence, pos + r->mask + 1, __ATOMIC_RELEASE);
+                return c;
+            }
+        } else if (diff < 0) {
+            return NULL;
+        } else {
+            pos = __atomic_load_n(&r->dequeue_pos, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+// One ring per priority class; the semaphore counts pushed entries so idle
+// lanes sleep instead of spinning.
+void shared_line_init(SharedLine* line, int capacity) {
+    memset(line, 0, sizeof(SharedLine));
+    for (int k = 0; k < priority_class_count; k++) mpmc_init(&line->rings[k], capacity);
+    sem_init(&line->ready, 0, 0);
+}
+
+void shared_line_free(SharedLine* line) {
+    for (int k = 0; k < priority_class_count; k++) mpmc_free(&line->rings[k]);
+    sem_destroy(&line->ready);
+}
+
+bool shared_line_push(SharedLine* line, Customer* c) {
+    if (!mpmc_push(&line->rings[c->priority], c)) return false;
+    __atomic_add_fetch(&line->size, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&line->class_items[c->priority], c->items, __ATOMIC_RELAXED);
+    sem_post(&line->ready);
+    return true;
+}
+
+// A customer leaves the line exactly once: either a lane claims them or their
+// patience runs out first. Reneged entries stay in the ring and are skipped.
+bool shared_line_claim(SharedLine* line, Customer* c) {
+    uint8_t expected = 0;
+    if (!__atomic_compare_exchange_n(&c->claimed, &expected, 1, false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+        return false;
+    }
+    __atomic_sub_fetch(&line->size, 1, __ATOMIC_RELAXED);
+    __atomic_sub_fetch(&line->class_items[c->priority], c->items, __ATOMIC_RELAXED);
+    return true;
+}
+
+// Holding a semaphore token guarantees a finished push nobody has taken yet;
+// the ring head may still be a push in flight, so retry until it lands.
+Customer* shared_line_pop(SharedLine* line, int timeout_ms) {
+    struct timespec deadline = deadline_after_ms(clock_real_ms(timeout_ms));
+
+    while (true) {
+        if (sem_timedwait(&line->ready, &deadline) != 0) {
+            if (errno == EINTR) continue;
+            return NULL;
+        }
+
+        Customer* c = NULL;
+        while (c == NULL) {
+            for (int k = 0; k < priority_class_count && c == NULL; k++) c = mpmc_pop(&line->rings[k]);
+            if (c == NULL) sched_yield();
+        }
+        if (shared_line_claim(line, c)) {
+            __atomic_add_fetch(&line->served, 1, __ATOMIC_RELAXED);
+            return c;
+        }
+        __atomic_store_n(&c->claimed, CUSTOMER_RING_RELEASED, __ATOMIC_RELEASE);
+    }
+}
+
+int shared_line_items_ahead(SharedLine* line, int priority) {
+    int items = 0;
+    for (int k = 0; k <= priority && k < priority_class_count; k++) {
+        items += __atomic_load_n(&line->class_items[k], __ATOMIC_RELAXED);
+    }
+    return items;
+}
+
+int shared_line_length(SharedLine* line) {
+    return __atomic_load_n(&line->size, __ATOMIC_RELAXED);
+}
+
+// Only open members take from the line; with none open the backlog still
+// counts against one lane.
+int shared_line_servers(SharedLine* line) {
+    int open = __atomic_load_n(&line->open_members, __ATOMIC_RELAXED);
+    return open > 0 ? open : 1;
+}
+
+// Items ahead of a new customer of this priority, spread over the lanes
+// taking from the line.
+float shared_line_share(SharedLine* line, int priority) {
+    return (float)shared_line_items_ahead(line, priority) / shared_line_servers(line);
+}
+
+// Anything left on the lane's own queue goes first; the jockey moves
+// customers into the line itself, so they never skip it. A lane that is
+// closing stops taking from the line.
+Customer* shared_line_next(SharedLine* line, Queue* own, const LaneStatus* status) {
+    while (simulation_running && !all_customers_served) {
+        pthread_mutex_lock(&own->lock);
+        Customer* c = own->size > 0 ? pop_front_locked(own) : NULL;
+        pthread_mutex_unlock(&own->lock);
+        if (c != NULL) return c;
+
+        if (status != NULL && *status != LANE_OPEN) {
+            c = dequeue_timeout(own, SHARED_LINE_POLL_MS);
+        } else {
+            c = shared_line_pop(line, SHARED_LINE_POLL_MS);
+        }
+        if (c != NULL) return c;
+    }
+    return NULL;
+}
+
+// Slots per class ring: the customers a line may hold, from the lane capacity
+// or SHARED_LINE_DEPTH per member without one, and as many again for reneged
+// entries no lane has popped yet.
+int shared_line_slots(int members) {
+    int depth = lane_capacity > 0 ? lane_capacity : SHARED_LINE_DEPTH;
+    return 2 * depth * members;
+}
+
+// Lines holding cashiers snake below the counters side by side; a kiosk-only
+// line snakes below the last kiosk.
+void init_shared_lines() {
+    int lanes = total_lane_count();
+    CheckoutType* kinds = (CheckoutType*)calloc(lanes > 0 ? lanes : 1, sizeof(CheckoutType));
+    int* limits = (int*)calloc(lanes > 0 ? lanes : 1, sizeof(int));
+    int* line_of = (int*)malloc(sizeof(int) * (lanes > 0 ? lanes : 1));
+    for (int i = 0; i < lanes; i++) {
+        kinds[i] = all_lanes[i].kind;
+        limits[i] = all_lanes[i].max_items;
+    }
+    shared_line_count = assign_shared_lines(kinds, limits, lanes, line_of);
+
+    bool with_cashiers[MAX_SHARED_LINES] = {false};
+    int members[MAX_SHARED_LINES] = {0};
+    for (int i = 0; i < lanes; i++) if (line_of[i] >= 0) members[line_of[i]]++;
+    for (int l = 0; l < shared_line_count; l++) shared_line_init(&shared_lines[l], shared_line_slots(members[l]));
+    for (int i = 0; i < lanes; i++) {
+        SharedLine* line = line_of[i] >= 0 ? &shared_lines[line_of[i]] : NULL;
+        all_lanes[i].line = line;
+        if (line == NULL) continue;
+        track_line_member(i, line_of[i]);
+        line->members++;
+        if (all_lanes[i].status == LANE_OPEN) line->open_members++;
+        line->max_items = limits[i];
+        if (all_lanes[i].kind == CASHIER) with_cashiers[line_of[i]] = true;
+    }
+
+    int cashier_lines = 0;
+    for (int l = 0; l < shared_line_count; l++) if (with_cashiers[l]) cashier_lines++;
+    float column = cashier_lines > 0 ? (kiosk_area_x - 40.0f) / cashier_lines : 0.0f;
+    int next_column = 0;
+    for (int l = 0; l < shared_line_count; l++) {
+        SharedLine* line = &shared_lines[l];
+        if (with_cashiers[l]) {
+            line->x = 20 + next_column * column + CUSTOMER_SIZE / 2;
+            line->y = SCREEN_HEIGHT / 3 + TABLE_HEIGHT / 2 + 20;
+            line->width = column - CUSTOMER_SIZE;
+            next_column++;
+        } else {
+            line->x = kiosk_area_x + 20 + CUSTOMER_SIZE / 2;
+            line->y = 120 + kiosk_row_height * selfcheckout_count + CUSTOMER_SIZE / 2;
+            line->width = KIOSK_AREA_WIDTH - 40 - CUSTOMER_SIZE;
+        }
+    }
+
+    free(line_of);
+    free(limits);
+    free(kinds);
+}
+
+void free_shared_lines() {
+    for (int l = 0; l < shared_line_count; l++) shared_line_free(&shared_lines[l]);
+    shared_line_count = 0;
+}
+
+int shared_line_index(SharedLine* line) {
+    return (int)(line - shared_lines);
+}
+
+// Boustrophedon rows: left to right, then back.
+void shared_line_position(SharedLine* line, int position, float* x, float* y) {
+    int per_row = (int)(line->width / CUSTOMER_SIZE) + 1;
+    int row = position / per_row;
+    int column = position % per_row;
+    if (row % 2 == 1) column = per_row - 1 - column;
+    *x = line->x + column * CUSTOMER_SIZE;
+    *y = line->y + row * CUSTOMER_SIZE;
+}
+
+void print_shared_line_summary() {
+    for (int l = 0; l < shared_line_count; l++) {
+        SharedLine* line = &shared_lines[l];
+        char limit[32] = "";
+        if (line->max_items > 0) snprintf(limit, sizeof(limit), ", <= %d items", line->max_items);
+        printf("Shared line %d (%d lanes%s): %d customers served from it\n", l + 1, line->members, limit, line->served);
+    }
+}
+
+void* dispatch_producer_function(void* arg) {
+    DispatchWorker* w = (DispatchWorker*)arg;
+    for (int i = 0; i < w->count; i++) {
+        if (w->line != NULL) {
+            while (!shared_line_push(w->line, &w->customers[i])) sched_yield();
+        } else {
+            enqueue(w->queue, &w->customers[i]);
+        }
+    }
+    return NULL;
+}
+
+void* dispatch_consumer_function(void* arg) {
+    DispatchWorker* w = (DispatchWorker*)arg;
+    while (__atomic_load_n(w->consumed, __ATOMIC_RELAXED) < w->total) {
+        Customer* c = w->line != NULL ? shared_line_pop(w->line, 10) : dequeue_timeout(w->queue, 10);
+        if (c != NULL) __atomic_add_fetch(w->consumed, 1, __ATOMIC_RELAXED);
+    }
+    return NULL;
+}
+
+// Equal numbers of producers and consumers hand customers through one mutex
+// queue or one shared line; the clock stops when the last one is taken.
+double benchmark_dispatch(int workers, bool lock_free) {
+    Customer* customers = (Customer*)calloc(DISPATCH_BENCH_ITEMS, sizeof(Customer));
+    SharedLine* line = NULL;
+    Queue* queue = NULL;
+    if (lock_free) {
+        line = (SharedLine*)malloc(sizeof(SharedLine));
+        shared_line_init(line, DISPATCH_BENCH_ITEMS);
+    } else {
+        queue = create_queue();
+    }
+
+    DispatchWorker* tasks = (DispatchWorker*)calloc(workers * 2, sizeof(DispatchWorker));
+    pthread_t* threads = (pthread_t*)malloc(sizeof(pthread_t) * workers * 2);
+    int consumed = 0;
+    int share = DISPATCH_BENCH_ITEMS / workers;
+
+    double start = wall_seconds();
+    for (int t = 0; t < workers * 2; t++) {
+        DispatchWorker* w = &tasks[t];
+        w->line = line;
+        w->queue = queue;
+        w->consumed = &consumed;
+        w->total = share * workers;
+        if (t < workers) {
+            w->customers = customers + t * share;
+            w->count = share;
+            pthread_create(&threads[t], NULL, dispatch_producer_function, w);
+        } else {
+            pthread_create(&threads[t], NULL, dispatch_consumer_function, w);
+        }
+    }
+    while (__atomic_load_n(&consumed, __ATOMIC_ACQUIRE) < share * workers) sched_yield();
+    double elapsed = wall_seconds() - start;
+    for (int t = 0; t < workers * 2; t++) pthread_join(threads[t], NULL);
+
+    if (line != NULL) {
+        shared_line_free(line);
+        free(line);
+    }
+    free(threads);
+    free(tasks);
+    free(customers);
+    return elapsed > 0 ? share * workers / elapsed : 0.0;
+}
+
+void run_shared_line_stores(int stores, WaitHistogram* waits, long long* served, double* seconds) {
+    histogram_reset(waits);
+    *served = 0;
+    *seconds = 0.0;
+    for (int i = 0; i < stores; i++) {
+        StoreSim* s = store_sim_create(i, i / stores_per_region, option_cashiers, option_kiosks, option_customers);
+        if (sim_duration > 0) {
+            store_sim_advance(s, sim_duration);
+        } else {
+            store_sim_run(s);
+        }
+        histogram_merge(waits, &s->waits);
+        *served += s->served;
+        *seconds += s->clock;
+        store_sim_destroy(s);
+    }
+}
+
+void run_shared_queue_comparison(int stores) {
+    SharedQueueMode modes[2] = {SHARED_OFF, shared_queue_mode != SHARED_OFF ? shared_queue_mode : SHARED_ALL};
+    WaitHistogram* waits = (WaitHistogram*)malloc(sizeof(WaitHistogram));
+    float p95[2];
+
+    printf("%-24s %10s  %10s  %9s  %8s  %8s\n", "queues", "customers", "per hour", "mean wait", "p95 wait", "max wait");
+    for (int m = 0; m < 2; m++) {
+        shared_queue_mode = modes[m];
+        long long served;
+        double seconds;
+        run_shared_line_stores(stores, waits, &served, &seconds);
+        p95[m] = histogram_percentile_ms(waits, 95.0f) / 1000.0f;
+        char label[40];
+        snprintf(label, sizeof(label), m == 0 ? "one per lane" : "shared (%s)", shared_queue_names[modes[m]]);
+        printf("%-24s %10lld  %10.0f  %7.2f s  %6.2f s  %6.2f s\n", label, served,
+               seconds > 0 ? served * 3600.0 / seconds : 0.0, histogram_mean_ms(waits) / 1000.0f,
+               p95[m], waits->max_ms / 1000.0f);
+    }
+    shared_queue_mode = modes[1];
+    printf("Shared lines change p95 wait by %+.2f s (%+.1f%%)\n", p95[1] - p95[0],
+           p95[0] > 0 ? (p95[1] - p95[0]) / p95[0] * 100.0f : 0.0f);
+
+    double locked = benchmark_dispatch(dispatch_workers, false);
+    double lock_free = benchmark_dispatch(dispatch_workers, true);
+    printf("Dispatch with %d producers and %d consumers: mutex queue %.2f M/s, MPMC line %.2f M/s (%.1fx)\n",
+           dispatch_workers, dispatch_workers, locked / 1e6, lock_free / 1e6, locked > 0 ? lock_free / locked : 0.0);
+    free(waits);
+}
@@ -0,0 +1,182 @@
+#include "structs.h"
+#include <errno.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+bool write_all(int fd, const void* buffer, size_t size) {
+    const char* p = (const char*)buffer;
+    while (size > 0) {
+        ssize_t written = write(fd, p, size);
+        if (written < 0 && errno == EINTR) continue;
+        if (written <= 0) return false;
+        p += written;
+        size -= (size_t)written;
+    }
+    return true;
+}
+
+bool read_all(int fd, void* buffer, size_t size) {
+    char* p = (char*)buffer;
+    while (size > 0) {
+        ssize_t got = read(fd, p, size);
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0) return false;
+        p += got;
+        size -= (size_t)got;
+    }
+    return true;
+}
+
+void worker_process_main(int fd, int worker, int workers) {
+    int store_total = 0;
+    for (int id = worker; id < store_count; id += workers) store_total++;
+
+    StoreSim** stores = (StoreSim**)malloc(sizeof(StoreSim*) * (store_total > 0 ? store_total : 1));
+    for (int i = 0; i < store_total; i++) {
+        int id = worker + i * workers;
+        stores[i] = store_sim_create(id, id / stores_per_region, option_cashiers, option_kiosks, option_customers);
+    }
+
+    WindowCommand command;
+    while (read_all(fd, &command, sizeof(command)) && !command.stop) {
+        WindowReport report;
+        memset(&report, 0, sizeof(report));
+        report.worker = worker;
+
+        for (int i = 0; i < store_total; i++) {
+            store_sim_advance(stores[i], command.until);
+            report.arrived += stores[i]->arrived;
+            report.served += stores[i]->served;
+            report.balked += stores[i]->balked;
+            report.reneged += stores[i]->reneged;
+            report.events += stores[i]->events_processed;
+            if (store_sim_done(stores[i])) report.stores_done++;
+        }
+
+        if (!write_all(fd, &report, sizeof(report))) break;
+    }
+
+    WaitHistogram* waits = (WaitHistogram*)malloc(sizeof(WaitHistogram));
+    histogram_reset(waits);
+    for (int i = 0; i < store_total; i++) {
+        histogram_merge(waits, &stores[i]->waits);
+        store_sim_destroy(stores[i]);
+    }
+    write_all(fd, waits, sizeof(WaitHistogram));
+    free(waits);
+    free(stores);
+    close(fd);
+}
+
+int run_distributed(int workers) {
+    if (workers > store_count) workers = store_count;
+
+    int* sockets = (int*)malloc(sizeof(int) * workers);
+    pid_t* pids = (pid_t*)malloc(sizeof(pid_t) * workers);
+    signal(SIGPIPE, SIG_IGN);
+    fflush(stdout);
+
+    for (int w = 0; w < workers; w++) {
+        int pair[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, pair) != 0) {
+            perror("socketpair");
+            return -1;
+        }
+
+        pid_t pid = fork();
+        if (pid < 0) {
+            perror("fork");
+            return -1;
+        }
+        if (pid == 0) {
+            close(pair[0]);
+            for (int i = 0; i < w; i++) close(sockets[i]);
+            worker_process_main(pair[1], w, workers);
+            _exit(0);
+        }
+
+        close(pair[1]);
+        sockets[w] = pair[0];
+        pids[w] = pid;
+    }
+
+    double start = wall_seconds();
+    double until = 0.0;
+    int windows = 0;
+    int stores_done = 0;
+    long long served = 0;
+    long long balked = 0;
+    long long reneged = 0;
+    long long events = 0;
+    bool failed = false;
+
+    while (stores_done < store_count && !failed && (sim_duration <= 0 || until < sim_duration)) {
+        until += window_seconds;
+        if (sim_duration > 0 && until > sim_duration) until = sim_duration;
+        WindowCommand command = {until, 0};
+        for (int w = 0; w < workers; w++) {
+            if (!write_all(sockets[w], &command, sizeof(command))) failed = true;
+        }
+
+        stores_done = 0;
+        served = 0;
+        balked = 0;
+        reneged = 0;
+        events = 0;
+        for (int w = 0; w < workers && !failed; w++) {
+            WindowReport report;
+            if (!read_all(sockets[w], &report, sizeof(report))) {
+                failed = true;
+                break;
+            }
+            stores_done += report.stores_done;
+            served += report.served;
+            balked += report.balked;
+            reneged += report.reneged;
+            events += report.events;
+        }
+        windows++;
+    }
+
+    WaitHistogram* waits = (WaitHistogram*)malloc(sizeof(WaitHistogram));
+    WaitHistogram* part = (WaitHistogram*)malloc(sizeof(WaitHistogram));
+    histogram_reset(waits);
+
+    WindowCommand stop = {0.0, 1};
+    for (int w = 0; w < workers; w++) {
+        write_all(sockets[w], &stop, sizeof(stop));
+        if (read_all(sockets[w], part, sizeof(WaitHistogram))) {
+            histogram_merge(waits, part);
+        } else {
+            failed = true;
+        }
+        close(sockets[w]);
+        waitpid(pids[w], NULL, 0);
+    }
+    double elapsed = wall_seconds() - start;
+
+    if (failed) {
+        printf("A worker process exited early; results are incomplete\n");
+    }
+    printf("Coordinated %d stores (%d per region) over %d worker processes: %d windows of %.0f s simulated time\n",
+           store_count, stores_per_region, workers, windows, window_seconds);
+    printf("Served %lld customers in %.3f s wall time (%.0f customers/s, %.0f events/s)\n",
+           served, elapsed, elapsed > 0 ? served / elapsed : 0.0, elapsed > 0 ? events / elapsed : 0.0);
+    printf("Wait time over %lld customers: mean %.2f s, p95 %.2f s, max %.2f s\n",
+           waits->count, histogram_mean_ms(waits) / 1000.0f,
+           histogram_percentile_ms(waits, 95.0f) / 1000.0f, waits->max_ms / 1000.0f);
+    if (lane_capacity > 0 || patience_mean > 0) {
+        char summary[128];
+        format_abandonment(summary, sizeof(summary), served + balked + reneged, balked, reneged);
+        printf("%s\n", summary);
+    }
+
+    free(part);
+    free(waits);
+    free(pids);
+    free(sockets);
+    return failed ? -1 : 0;
+}
@@ -0,0 +1,402 @@
+#include "structs.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ESTIMATE_ITERATIONS 20
+#define ESTIMATE_TOLERANCE 1e-3
+#define ESTIMATE_MAX_UTILIZATION 0.98
+
+int compare_estimate_lanes(const void* a, const void* b) {
+    double sa = ((const EstimateLane*)a)->speed;
+    double sb = ((const EstimateLane*)b)->speed;
+    return sa < sb ? -1 : sa > sb;
+}
+
+// Erlang C through the Erlang B recursion, which stays finite for any number
+// of servers.
+double erlang_c(int servers, double offered) {
+    double b = 1.0;
+    for (int k = 1; k <= servers; k++) b = offered * b / (k + offered * b);
+    double rho = offered / servers;
+    return b / (1.0 - rho * (1.0 - b));
+}
+
+// Probability of each cart size, read back out of the alias table.
+int cart_probabilities(double* p) {
+    if (uniform_carts()) {
+        for (int k = 0; k < 15; k++) p[k] = 1.0 / 15.0;
+        return 15;
+    }
+    for (int column = 0; column < cart_table.size; column++) {
+        p[column] = cart_table.prob[column];
+        for (int j = 0; j < cart_table.size; j++) {
+            if (cart_table.alias[j] == column && j != column) p[column] += 1.0 - cart_table.prob[j];
+        }
+        p[column] /= cart_table.size;
+    }
+    return cart_table.size;
+}
+
+// Same streams as store_sim_create, so the estimate sees the store's own lanes.
+void store_estimate_lanes(int store, EstimateLane* lanes) {
+    for (int i = 0; i < option_cashiers + option_kiosks; i++) {
+        EstimateLane* lane = &lanes[i];
+        memset(lane, 0, sizeof(EstimateLane));
+        if (i < option_cashiers) {
+            RngStream rng;
+            rng_seed(&rng, simulation_seed, replication_id, STREAM_CASHIER, store * 65536 + i);
+            lane->speed = initial_cashier_speed(i, &rng);
+            lane->max_items = cashier_item_limit(i);
+        } else {
+            lane->speed = kiosk_speed;
+            lane->max_items = kiosk_item_limit;
+        }
+    }
+}
+
+// Mean-field model of least-work routing. Each lane is taken as busy with
+// probability rho, independently of the others, with an exponential residual
+// service of mean theta. A customer with k items joins the lane minimising
+// backlog + speed * k, so on each stretch between consecutive speed * k the
+// probability that every lane costs more than x is exp(a - b x); its
+// integrals give, per lane, the chance of being chosen while busy and the
+// expected wait there in closed form. Lanes are visited fastest first, so
+// each cart size costs O(lanes).
+//
+// a is the sum of log rho plus terms fixed by the lanes and the cart, so
+// exp(a - b x) is the running product of rho times a factor computed once per
+// store here; the fixed-point iterations and the rate-curve segments then
+// only multiply.
+void prepare_cart_choices(CartChoices* choices, EstimateLane* lanes, int count, const double* carts, int sizes) {
+    choices->lanes = count;
+    choices->index = (int*)malloc(sizeof(int) * sizes * count);
+    choices->beta = (double*)malloc(sizeof(double) * sizes * count * 3);
+    choices->head = choices->beta + sizes * count;
+    choices->tail = choices->head + sizes * count;
+
+    for (int k = 0; k < sizes; k++) {
+        int items = k + 1;
+        int* index = choices->index + k * count;
+        int used = 0;
+        choices->used[k] = 0;
+        if (carts[k] <= 0) continue;
+        for (int i = 0; i < count; i++) {
+            if (lanes[i].max_items == 0 || items <= lanes[i].max_items) index[used++] = i;
+        }
+        if (used == 0) {
+            for (int i = 0; i < count; i++) index[i] = i;
+            used = count;
+        }
+        choices->used[k] = used;
+
+        double a = 0.0, b = 0.0;
+        for (int n = 0; n < used; n++) {
+            EstimateLane* lane = &lanes[index[n]];
+            double start = lane->speed * items;
+            a += start / lane->theta;
+            b += 1.0 / lane->theta;
+            choices->beta[k * count + n] = b;
+            choices->head[k * count + n] = exp(a - b * start);
+            choices->tail[k * count + n] = n + 1 < used ? exp(a - b * lanes[index[n + 1]].speed * items) : 0.0;
+        }
+    }
+}
+
+void free_cart_choices(CartChoices* choices) {
+    free(choices->index);
+    free(choices->beta);
+}
+
+double cart_choices(EstimateLane* lanes, const CartChoices* choices, int items, double weight, double* wait_probability) {
+    int row = (items - 1) * choices->lanes;
+    const int* index = choices->index + row;
+    const double* beta = choices->beta + row;
+    int used = choices->used[items - 1];
+
+    double busy = 1.0;
+    for (int n = 0; n < used; n++) {
+        EstimateLane* lane = &lanes[index[n]];
+        busy *= lane->rho;
+        lane->head = busy * choices->head[row + n];
+        lane->tail = busy * choices->tail[row + n];
+    }
+
+    double after = 0.0, area_after = 0.0, wait = 0.0;
+    for (int n = used - 1; n >= 0; n--) {
+        EstimateLane* lane = &lanes[index[n]];
+        double gap = n + 1 < used ? (lanes[index[n + 1]].speed - lane->speed) * items : 0.0;
+        double area = (lane->head - lane->tail) / (beta[n] * beta[n]) + (after - lane->tail / beta[n]) * gap;
+        after += (lane->head - lane->tail) / beta[n];
+        area_after += area;
+
+        lane->work += weight * after / lane->theta * lane->speed * items;
+        *wait_probability += weight * after / lane->theta;
+        wait += weight * area_after / lane->theta;
+    }
+
+    // Idle lanes tied on speed split the customers who find one of them free.
+    for (int n = 0; n < used;) {
+        int end = n;
+        double speed = lanes[index[n]].speed;
+        while (end < used && lanes[index[end]].speed == speed) end++;
+        double reach = n > 0 ? lanes[index[n - 1]].tail : 1.0;
+        double all_busy = 1.0, idle = 0.0;
+        for (int m = n; m < end; m++) {
+            all_busy *= lanes[index[m]].rho;
+            idle += 1.0 - lanes[index[m]].rho;
+        }
+        for (int m = n; m < end && idle > 0; m++) {
+            EstimateLane* lane = &lanes[index[m]];
+            lane->work += weight * reach * (1.0 - all_busy) * (1.0 - lane->rho) / idle * speed * items;
+        }
+        n = end;
+    }
+    return wait;
+}
+
+// The mean-field part is the wait of customers who hold out for a faster busy
+// lane rather than start at a slower idle one, which pooling the lanes misses;
+// queueing when every lane is busy comes from the pooled M/G/c wait
+// (Allen-Cunneen). Lane utilisations are iterated to a fixed point with the
+// choice probabilities they induce, each segment starting from the last one's.
+void add_wait_component(QueueEstimate* e, EstimateLane* lanes, const CartChoices* choices, const double* carts,
+                        int sizes, double weight, double lambda, double ca2, double cs2) {
+    double rho = lambda / e->capacity;
+    e->utilization += weight * rho;
+    if (rho > e->peak_utilization) e->peak_utilization = rho;
+    if (rho >= 1.0) {
+        e->saturated_share += weight;
+        return;
+    }
+
+    if (e->components == 0) {
+        for (int i = 0; i < e->servers; i++) lanes[i].rho = rho;
+    }
+    double wait = 0.0, wait_probability = 0.0;
+    double change = 1.0, step = 0.5;
+    for (int iteration = 0; iteration <= ESTIMATE_ITERATIONS && change > ESTIMATE_TOLERANCE; iteration++) {
+        for (int i = 0; i < e->servers; i++) {
+            EstimateLane* lane = &lanes[i];
+            if (lane->rho < 1e-9) lane->rho = 1e-9;
+            if (lane->rho > ESTIMATE_MAX_UTILIZATION) lane->rho = ESTIMATE_MAX_UTILIZATION;
+            lane->work = 0.0;
+        }
+        wait = 0.0;
+        wait_probability = 0.0;
+        for (int k = 0; k < sizes; k++) {
+            if (carts[k] > 0) wait += cart_choices(lanes, choices, k + 1, carts[k], &wait_probability);
+        }
+        double last = change;
+        change = 0.0;
+        for (int i = 0; i < e->servers; i++) {
+            double next = lanes[i].rho + step * (lambda * lanes[i].work - lanes[i].rho);
+            if (next < 1e-9) next = 1e-9;
+            if (next > ESTIMATE_MAX_UTILIZATION) next = ESTIMATE_MAX_UTILIZATION;
+            if (fabs(next - lanes[i].rho) > change) change = fabs(next - lanes[i].rho);
+            lanes[i].rho = next;
+        }
+        if (change > last) step /= 2.0;
+    }
+
+    double queued = erlang_c(e->servers, rho * e->servers);
+    wait += queued * (ca2 + cs2) / 2.0 / (e->capacity - lambda);
+    wait_probability = 1.0 - (1.0 - wait_probability) * (1.0 - queued);
+
+    int k = e->components++;
+    e->weight[k] = weight;
+    e->wait_probability[k] = wait_probability;
+    e->conditional_wait[k] = wait_probability > 0 ? wait / wait_probability : 0.0;
+}
+
+void estimate_store(QueueEstimate* e, int store) {
+    memset(e, 0, sizeof(QueueEstimate));
+    e->servers = option_cashiers + option_kiosks;
+    if (e->servers <= 0) return;
+
+    double carts[MAX_CART_ITEMS];
+    int sizes = cart_probabilities(carts);
+    double mean_items = 0.0, second_items = 0.0;
+    for (int k = 0; k < sizes; k++) {
+        mean_items += carts[k] * (k + 1);
+        second_items += carts[k] * (k + 1) * (k + 1);
+    }
+    second_items *= exp(service_time_noise * service_time_noise);
+    double cs2 = second_items / (mean_items * mean_items) - 1.0;
+
+    EstimateLane* lanes = (EstimateLane*)malloc(sizeof(EstimateLane) * e->servers);
+    store_estimate_lanes(store, lanes);
+    qsort(lanes, e->servers, sizeof(EstimateLane), compare_estimate_lanes);
+    for (int i = 0; i < e->servers; i++) {
+        e->capacity += 1.0 / (lanes[i].speed * mean_items);
+        lanes[i].theta = lanes[i].speed * second_items / (2.0 * mean_items);
+    }
+    CartChoices choices;
+    prepare_cart_choices(&choices, lanes, e->servers, carts, sizes);
+
+    if (uniform_arrivals()) {
+        double gap = (arrival_gap_min_ms + arrival_gap_max_ms) / 2.0;
+        double span = arrival_gap_max_ms - arrival_gap_min_ms + 1.0;
+        e->arrival_rate = 1000.0 / gap;
+        add_wait_component(e, lanes, &choices, carts, sizes, 1.0, e->arrival_rate, (span * span - 1.0) / 12.0 / (gap * gap), cs2);
+        free_cart_choices(&choices);
+        free(lanes);
+        return;
+    }
+
+    // Pointwise-stationary: each segment of the curve inside the horizon is
+    // solved on its own and weighted by the arrivals it brings.
+    double arrivals[RATE_CURVE_MAX_SEGMENTS] = {0};
+    double horizon = arrival_horizon_hours * 3600.0;
+    double total = 0.0;
+    for (double t = 0.0; t < horizon;) {
+        double day_time = fmod(t + arrival_curve.offset_seconds, 86400.0);
+        int segment = (int)(day_time / arrival_curve.segment_seconds);
+        if (segment >= arrival_curve.segments) segment = arrival_curve.segments - 1;
+        double left = (segment + 1) * arrival_curve.segment_seconds - day_time;
+        if (left > horizon - t) left = horizon - t;
+        arrivals[segment] += arrival_curve.rates[segment] * left;
+        total += arrival_curve.rates[segment] * left;
+        t += left;
+    }
+    if (total > 0) {
+        e->arrival_rate = total / horizon;
+        for (int k = 0; k < arrival_curve.segments; k++) {
+            if (arrivals[k] > 0) add_wait_component(e, lanes, &choices, carts, sizes, arrivals[k] / total, arrival_curve.rates[k], 1.0, cs2);
+        }
+    }
+    free_cart_choices(&choices);
+    free(lanes);
+}
+
+double estimate_mean_wait(const QueueEstimate* e) {
+    if (e->saturated_share > 0) return INFINITY;
+    double mean = 0.0;
+    for (int k = 0; k < e->components; k++) mean += e->weight[k] * e->wait_probability[k] * e->conditional_wait[k];
+    return mean;
+}
+
+double estimate_tail(const QueueEstimate* e, int count, double t) {
+    double tail = 0.0;
+    for (int i = 0; i < count; i++) {
+        tail += e[i].saturated_share;
+        for (int k = 0; k < e[i].components; k++) {
+            tail += e[i].weight[k] * e[i].wait_probability[k] * exp(-t / e[i].conditional_wait[k]);
+        }
+    }
+    return tail / count;
+}
+
+// Quantile of the wait over one or more stores with equal arrivals each.
+double estimate_wait_quantile(const QueueEstimate* e, int count, double percentile) {
+    double target = 1.0 - percentile / 100.0;
+    if (estimate_tail(e, count, 0.0) <= target) return 0.0;
+
+    double lo = 0.0, hi = 1.0;
+    while (estimate_tail(e, count, hi) > target) {
+        if (hi > 1e9) return INFINITY;
+        lo = hi;
+        hi *= 2.0;
+    }
+    for (int i = 0; i < 60; i++) {
+        double mid = (lo + hi) / 2.0;
+        if (estimate_tail(e, count, mid) > target) lo = mid;
+        else hi = mid;
+    }
+    return hi;
+}
+
+double estimate_wait_probability(const QueueEstimate* e) {
+    return estimate_tail(e, 1, 0.0);
+}
+
+void format_estimate_wait(char* text, size_t size, double seconds) {
+    if (isfinite(seconds)) snprintf(text, size, "%.2f s", seconds);
+    else snprintf(text, size, "unbounded");
+}
+
+void print_estimate(const QueueEstimate* e, double micros) {
+    printf("Estimate for %d lanes (capacity %.3f customers/s) in %.1f us\n", e->servers, e->capacity, micros);
+    printf("Arrivals %.3f customers/s, utilization %.1f%% (peak %.1f%%)\n",
+           e->arrival_rate, e->utilization * 100.0, e->peak_utilization * 100.0);
+    if (e->saturated_share > 0) {
+        printf("Lanes are saturated for %.1f%% of arrivals; waits grow without bound there\n", e->saturated_share * 100.0);
+    }
+    char mean[32], p95[32], p99[32];
+    format_estimate_wait(mean, sizeof(mean), estimate_mean_wait(e));
+    format_estimate_wait(p95, sizeof(p95), estimate_wait_quantile(e, 1, 95.0));
+    format_estimate_wait(p99, sizeof(p99), estimate_wait_quantile(e, 1, 99.0));
+    printf("Wait: P(wait) %.1f%%, mean %s, p95 %s, p99 %s\n", estimate_wait_probability(e) * 100.0, mean, p95, p99);
+}
+
+void print_estimate_error(const char* metric, double predicted, double simulated) {
+    if (!isfinite(predicted)) {
+        printf("%-10s %12s %10.2f s  %9s\n", metric, "unbounded", simulated, "-");
+        return;
+    }
+    printf("%-10s %10.2f s %10.2f s  %+8.1f%%\n", metric, predicted, simulated,
+           simulated > 0 ? (predicted - simulated) / simulated * 100.0 : 0.0);
+}
+
+int run_estimate(int stores) {
+    QueueEstimate* estimates = (QueueEstimate*)malloc(sizeof(QueueEstimate) * stores);
+    double start = wall_seconds();
+    for (int i = 0; i < stores; i++) estimate_store(&estimates[i], i);
+    double estimated = wall_seconds() - start;
+
+    if (!estimate_validate) {
+        print_estimate(&estimates[0], estimated * 1e6 / stores);
+        free(estimates);
+        return 0;
+    }
+
+    WaitHistogram* waits = (WaitHistogram*)malloc(sizeof(WaitHistogram));
+    histogram_reset(waits);
+    double predicted_mean = 0.0;
+    double store_error = 0.0;
+    int compared = 0;
+    start = wall_seconds();
+    for (int i = 0; i < stores; i++) {
+        StoreSim* s = store_sim_create(i, i / stores_per_region, option_cashiers, option_kiosks, option_customers);
+        if (s->initial_burst > 0) {
+            s->initial_burst = 0;
+            sim_schedule_next_arrival(s);
+        }
+        if (warmup_seconds > 0) {
+            store_sim_advance(s, warmup_seconds);
+            histogram_reset(&s->waits);
+        }
+        if (sim_duration > 0) store_sim_advance(s, sim_duration);
+        else store_sim_run(s);
+
+        double predicted = estimate_mean_wait(&estimates[i]);
+        double simulated = histogram_mean_ms(&s->waits) / 1000.0;
+        predicted_mean += predicted / stores;
+        if (simulated > 0 && isfinite(predicted)) {
+            store_error += fabs(predicted - simulated) / simulated;
+            compared++;
+        }
+        histogram_merge(waits, &s->waits);
+        store_sim_destroy(s);
+    }
+    double simulated_seconds = wall_seconds() - start;
+
+    printf("Estimated %d stores in %.1f us each; simulated them in %.2f ms each (%.0fx faster)\n",
+           stores, estimated * 1e6 / stores, simulated_seconds * 1e3 / stores,
+           estimated > 0 ? simulated_seconds / estimated : 0.0);
+    printf("%-10s %12s %12s  %9s\n", "wait", "estimated", "simulated", "error");
+    print_estimate_error("mean", predicted_mean, histogram_mean_ms(waits) / 1000.0);
+    print_estimate_error("p95", estimate_wait_quantile(estimates, stores, 95.0),
+                         histogram_percentile_ms(waits, 95.0f) / 1000.0);
+    print_estimate_error("p99", estimate_wait_quantile(estimates, stores, 99.0),
+                         histogram_percentile_ms(waits, 99.0f) / 1000.0);
+    if (compared > 0) {
+        printf("Mean absolute error of the per-store mean wait: %.1f%% over %d stores\n",
+               store_error / compared * 100.0, compared);
+    }
+
+    free(waits);
+    free(estimates);
+    return 0;
+}
@@ -0,0 +1,147 @@
+#include "structs.h"
+#include <pthread.h>
+
+#define JOCKEY_MAX_MOVES_PER_LANE 4
+
+int jockey_moves = 0;
+int jockey_passes = 0;
+double jockey_estimated_gain = 0.0;
+Uint64 jockey_cost_ticks = 0;
+Uint32 next_jockey_time = 0;
+volatile bool lane_event_pending = false;
+
+Queue* lane_queue(int lane) {
+    return all_lanes[lane].queue;
+}
+
+bool lane_accepts_customers(int lane) {
+    return all_lanes[lane].status == LANE_OPEN;
+}
+
+// A lane in a shared line takes the customer at the back of its line, not
+// ahead of it on the lane's own queue. If the line's ring is full the customer
+// goes back to the end of the queue they came from.
+void move_customer_to_lane(Customer* c, int from, int lane) {
+    SharedLine* line = all_lanes[lane].line;
+    pthread_mutex_lock(&visualization_lock);
+    if (line != NULL) place_in_shared_line(c, line);
+    else place_in_lane_queue(c, &all_lanes[lane]);
+    c->visual_state = MOVING_TO_QUEUE;
+    pthread_mutex_unlock(&visualization_lock);
+
+    if (line == NULL) {
+        enqueue(lane_queue(lane), c);
+    } else if (!shared_line_push(line, c)) {
+        pthread_mutex_lock(&visualization_lock);
+        place_in_lane_queue(c, &all_lanes[from]);
+        pthread_mutex_unlock(&visualization_lock);
+        enqueue(lane_queue(from), c);
+    }
+}
+
+void rebalance_queues() {
+    int lanes = total_lane_count();
+    if (lanes < 2) return;
+
+    Uint64 start = SDL_GetPerformanceCounter();
+    float* workload = (float*)malloc(sizeof(float) * lanes);
+    float* speed = (float*)malloc(sizeof(float) * lanes);
+    int* queued = (int*)malloc(sizeof(int) * lanes);
+    float moved_to_line[MAX_SHARED_LINES] = {0};
+
+    pthread_mutex_lock(&visualization_lock);
+    for (int lane = 0; lane < lanes; lane++) {
+        speed[lane] = lane_routing_speed(&all_lanes[lane]);
+        workload[lane] = lane_remaining_seconds(&all_lanes[lane]);
+    }
+    pthread_mutex_unlock(&visualization_lock);
+
+    for (int lane = 0; lane < lanes; lane++) {
+        Queue* q = lane_queue(lane);
+        pthread_mutex_lock(&q->lock);
+        workload[lane] += speed[lane] * q->total_items;
+        queued[lane] = q->size;
+        pthread_mutex_unlock(&q->lock);
+
+        SharedLine* line = all_lanes[lane].line;
+        if (line != NULL) queued[lane] += shared_line_length(line) / line->members;
+    }
+
+    for (int from = 0; from < lanes; from++) {
+        Customer* moved[JOCKEY_MAX_MOVES_PER_LANE];
+        int targets[JOCKEY_MAX_MOVES_PER_LANE];
+        int count = 0;
+        Queue* q = lane_queue(from);
+
+        pthread_mutex_lock(&q->lock);
+        while (count < JOCKEY_MAX_MOVES_PER_LANE && q->rear != NULL) {
+            Customer* c = q->rear->data;
+            float finish_here = workload[from];
+            float best_finish = FLT_MAX;
+            int best_lane = -1;
+
+            for (int to = 0; to < lanes; to++) {
+                if (to == from || !lane_accepts_customers(to) || lane_full(queued[to])) continue;
+                if (!lane_eligible(&lane_eligibility, to, c->items)) continue;
+                float finish = workload[to] + speed[to] * c->items;
+                SharedLine* line = all_lanes[to].line;
+                if (line != NULL) {
+                    int l = shared_line_index(line);
+                    finish += speed[to] * (shared_line_share(line, c->priority) + moved_to_line[l] / shared_line_servers(line));
+                }
+                if (finish < best_finish) {
+                    best_finish = finish;
+                    best_lane = to;
+                }
+            }
+
+            if (best_lane < 0 || finish_here - best_finish <= jockey_threshold) break;
+
+            pop_back_locked(q);
+            workload[from] -= speed[from] * c->items;
+            if (all_lanes[best_lane].line != NULL) {
+                moved_to_line[shared_line_index(all_lanes[best_lane].line)] += c->items;
+            } else {
+                workload[best_lane] += speed[best_lane] * c->items;
+            }
+            queued[from]--;
+            queued[best_lane]++;
+            jockey_estimated_gain += finish_here - best_finish;
+            moved[count] = c;
+            targets[count] = best_lane;
+            count++;
+        }
+        pthread_mutex_unlock(&q->lock);
+
+        for (int i = 0; i < count; i++) {
+            move_customer_to_lane(moved[i], from, targets[i]);
+        }
+        jockey_moves += count;
+    }
+
+    free(workload);
+    free(speed);
+    free(queued);
+    jockey_passes++;
+    jockey_cost_ticks += SDL_GetPerformanceCounter() - start;
+}
+
+void maybe_rebalance_queues() {
+    if (!jockeying_enabled) return;
+
+    Uint32 now = sim_ticks();
+    if (lane_event_pending || now >= next_jockey_time) {
+        lane_event_pending = false;
+        next_jockey_time = now + jockey_interval_ms;
+        rebalance_queues();
+    }
+}
+
+void print_jockey_summary() {
+    if (!jockeying_enabled) return;
+
+    double cost_us = jockey_cost_ticks * 1000000.0 / SDL_GetPerformanceFrequency();
+    printf("Jockeying: %d moves in %d passes, estimated %.1f s of waiting saved, %.0f us spent re-evaluating (%.1f us/pass)\n",
+           jockey_moves, jockey_passes, jockey_estimated_gain, cost_us,
+           jockey_passes > 0 ? cost_us / jockey_passes : 0.0);
+}
@@ -0,0 +1,206 @@
+#include "structs.h"
+#include <pthread.h>
+#include <stdlib.h>
+
+Lane* all_lanes = NULL;
+
+int total_lane_count() {
+    return cashier_count + selfcheckout_count;
+}
+
+Lane* cashier_lane(int index) {
+    return &all_lanes[index];
+}
+
+Lane* kiosk_lane(int index) {
+    return &all_lanes[cashier_count + index];
+}
+
+int lane_index(Lane* lane) {
+    return (int)(lane - all_lanes);
+}
+
+void init_lane(Lane* lane, CheckoutType kind, int index) {
+    lane->kind = kind;
+    lane->id = index + 1;
+    lane->queue = create_queue();
+    lane->is_serving = false;
+    lane->current_customer = NULL;
+    lane->total_items_processed = 0;
+    lane->total_customers_served = 0;
+    lane->customers_stolen = 0;
+    lane->status = LANE_OPEN;
+    lane->busy_ms = 0;
+    lane->line = NULL;
+
+    if (kind == CASHIER) {
+        lane->max_items = cashier_item_limit(index);
+        rng_seed(&lane->rng, simulation_seed, replication_id, STREAM_CASHIER, index);
+        lane->avg_service_time_per_item = initial_cashier_speed(index, &lane->rng);
+        init_service_estimate(&lane->estimate, cashier_speed_prior);
+        lane->x = (int)((index + 1) * cashier_pitch);
+        lane->y = SCREEN_HEIGHT / 3;
+    } else {
+        lane->max_items = kiosk_item_limit;
+        rng_seed(&lane->rng, simulation_seed, replication_id, STREAM_KIOSK, index);
+        lane->avg_service_time_per_item = kiosk_speed;
+        init_service_estimate(&lane->estimate, kiosk_speed_prior);
+        lane->x = kiosk_area_x + KIOSK_AREA_WIDTH/2;
+        lane->y = 120 + (kiosk_row_height * index) + (kiosk_row_height / 2);
+    }
+}
+
+void init_lanes() {
+    all_lanes = (Lane*)calloc(total_lane_count(), sizeof(Lane));
+    for (int i = 0; i < cashier_count; i++) init_lane(cashier_lane(i), CASHIER, i);
+    for (int i = 0; i < selfcheckout_count; i++) init_lane(kiosk_lane(i), KIOSK, i);
+    init_lane_vectors();
+}
+
+// Cashier customers queue down from the table and are served at its near
+// end; kiosk customers queue across the row and stand at the kiosk itself.
+void lane_queue_slot(Lane* lane, int position, float* x, float* y) {
+    if (lane->kind == CASHIER) {
+        *x = lane->x;
+        *y = lane->y + TABLE_HEIGHT/2 + 20 + (position * CUSTOMER_SIZE);
+    } else {
+        *x = kiosk_area_x + 20 + (position * CUSTOMER_SIZE);
+        *y = lane->y;
+    }
+}
+
+void lane_service_point(Lane* lane, float* x, float* y) {
+    *x = lane->x;
+    *y = lane->kind == CASHIER ? lane->y + (TABLE_HEIGHT/2) - 20 : lane->y;
+}
+
+void set_lane_status(Lane* lane, LaneStatus status) {
+    if (lane->line != NULL && (lane->status == LANE_OPEN) != (status == LANE_OPEN)) {
+        __atomic_add_fetch(&lane->line->open_members, status == LANE_OPEN ? 1 : -1, __ATOMIC_RELAXED);
+    }
+    lane->status = status;
+    track_lane_status(lane);
+}
+
+bool customer_in_lane(Customer* c, Lane* lane) {
+    return c->lane_id == lane_index(lane) + 1;
+}
+
+Lane* customer_lane(Customer* c) {
+    return c->lane_id > 0 ? &all_lanes[c->lane_id - 1] : NULL;
+}
+
+void claim_customer(Lane* lane, Customer* c) {
+    c->visual_state = BEING_SERVED;
+    c->line_id = 0;
+    c->lane_id = lane_index(lane) + 1;
+    c->reached_lane = false;
+    lane_service_point(lane, &c->target_x, &c->target_y);
+}
+
+void* lane_function(void* arg) {
+    Lane* lane = (Lane*)arg;
+
+    while (simulation_running) {
+        Customer* c = lane_next_customer(lane);
+
+        if (c == NULL) break;
+
+        pthread_mutex_lock(&visualization_lock);
+        claim_customer(lane, c);
+        lane->is_serving = true;
+        lane->current_customer = c;
+        pthread_mutex_unlock(&visualization_lock);
+        request_redraw();
+
+        bool customer_ready = false;
+        while (!customer_ready && simulation_running) {
+            pthread_mutex_lock(&visualization_lock);
+            customer_ready = c->reached_lane;
+            pthread_mutex_unlock(&visualization_lock);
+            sim_sleep_ms(50);
+        }
+
+        if (!simulation_running) break;
+
+        pthread_mutex_lock(&visualization_lock);
+        c->service_start_time = sim_ticks();
+        c->service_duration_ms = draw_service_ms(&lane->rng, lane->avg_service_time_per_item, c->items);
+        pthread_mutex_unlock(&visualization_lock);
+        track_service(lane, c);
+        request_redraw();
+
+        record_customer_wait(c);
+
+        int service_time_ms = (int)c->service_duration_ms;
+
+        sim_sleep_ms(service_time_ms);
+
+        Uint32 service_ms = sim_ticks() - c->service_start_time;
+        observe_service(&lane->estimate, c->items, service_ms, lane->avg_service_time_per_item);
+        track_lane_speed(lane);
+        track_service(lane, NULL);
+        lane->busy_ms += service_ms;
+        lane->total_items_processed += c->items;
+        lane->total_customers_served++;
+
+        pthread_mutex_lock(&visualization_lock);
+        c->visual_state = LEAVING;
+        lane->is_serving = false;
+        lane->current_customer = NULL;
+        pthread_mutex_unlock(&visualization_lock);
+        request_redraw();
+
+        // An emptied queue asks the jockey to rebalance early. A lane in a
+        // shared line takes its next customer from the line, so its own
+        // queue being empty says nothing.
+        if (lane->line == NULL) {
+            pthread_mutex_lock(&lane->queue->lock);
+            bool empty = lane->queue->size == 0;
+            pthread_mutex_unlock(&lane->queue->lock);
+            if (empty) lane_event_pending = true;
+        }
+
+        sim_sleep_ms(200);
+
+        pthread_mutex_lock(&customers_served_lock);
+        customers_served++;
+        if (customers_served + customers_balked + customers_reneged >= total_customers) {
+            all_customers_served = 1;
+            simulation_end_time = sim_ticks();
+        }
+        pthread_mutex_unlock(&customers_served_lock);
+        request_redraw();
+    }
+
+    return NULL;
+}
+
+void start_lanes() {
+    for (int i = 0; i < total_lane_count(); i++) {
+        pthread_create(&all_lanes[i].thread, NULL, lane_function, &all_lanes[i]);
+    }
+}
+
+void stop_lanes() {
+    for (int i = 0; i < total_lane_count(); i++) {
+        pthread_cond_broadcast(&all_lanes[i].queue->cond);
+    }
+    for (int i = 0; i < total_lane_count(); i++) {
+        pthread_join(all_lanes[i].thread, NULL);
+    }
+}
+
+void free_lanes() {
+    if (all_lanes == NULL) return;
+    for (int i = 0; i < total_lane_count(); i++) {
+        if (all_lanes[i].queue) {
+            pthread_mutex_destroy(&all_lanes[i].queue->lock);
+            pthread_cond_destroy(&all_lanes[i].queue->cond);
+            free(all_lanes[i].queue);
+        }
+    }
+    free(all_lanes);
+    all_lanes = NULL;
+    free_lane_vectors();
+}
@@ -0,0 +1,108 @@
+#include "structs.h"
+#include <stdlib.h>
+#include <string.h>
+
+EligibilityTable lane_eligibility;
+
+int cashier_item_limit(int index) {
+    return index < express_lanes ? express_item_limit : 0;
+}
+
+int eligibility_bucket(int items) {
+    if (items < 0) return 0;
+    return items < ELIGIBILITY_BUCKETS - 1 ? items : ELIGIBILITY_BUCKETS - 1;
+}
+
+// A limit of 0 means "any cart". Limits that reach the last bucket cannot be
+// told apart from no limit and are treated as such.
+void build_eligibility(EligibilityTable* table, const int* limits, int lanes) {
+    table->lanes = lanes;
+    table->words = (lanes + 63) / 64;
+    if (table->words == 0) table->words = 1;
+    table->bits = (uint64_t*)calloc((size_t)ELIGIBILITY_BUCKETS * table->words, sizeof(uint64_t));
+
+    for (int bucket = 0; bucket < ELIGIBILITY_BUCKETS; bucket++) {
+        uint64_t* row = table->bits + (size_t)bucket * table->words;
+        bool any = false;
+        for (int lane = 0; lane < lanes; lane++) {
+            int limit = limits[lane];
+            if (limit == 0 || limit >= ELIGIBILITY_BUCKETS - 1 || bucket <= limit) {
+                row[lane / 64] |= 1ULL << (lane % 64);
+                any = true;
+            }
+        }
+        if (!any) {
+            for (int lane = 0; lane < lanes; lane++) row[lane / 64] |= 1ULL << (lane % 64);
+        }
+    }
+}
+
+void free_eligibility(EligibilityTable* table) {
+    free(table->bits);
+    table->bits = NULL;
+}
+
+const uint64_t* eligible_lanes(EligibilityTable* table, int items) {
+    return table->bits + (size_t)eligibility_bucket(items) * table->words;
+}
+
+bool lane_eligible(EligibilityTable* table, int lane, int items) {
+    if (table->bits == NULL) return true;
+    return (eligible_lanes(table, items)[lane / 64] >> (lane % 64)) & 1;
+}
+
+void lane_vector_offsets(LaneIndexVector* offsets) {
+    for (int i = 0; i < LANE_VECTOR_WIDTH; i++) (*offsets)[i] = i;
+}
+
+// All ones for the lanes of routing vector v that the bitset admits; the
+// vector's lanes are LANE_VECTOR_WIDTH consecutive bits of one word.
+void admitted_lanes(const uint64_t* eligible, int v, LaneIndexVector* mask) {
+    int first = v * LANE_VECTOR_WIDTH;
+    int bits = (int)((eligible[first / 64] >> (first % 64)) & ((1u << LANE_VECTOR_WIDTH) - 1));
+    LaneIndexVector lane_bits;
+    for (int i = 0; i < LANE_VECTOR_WIDTH; i++) lane_bits[i] = 1 << i;
+    *mask = (((LaneIndexVector){0} + bits) & lane_bits) != 0;
+}
+
+// Whether every customer a lane with victim_limit may hold is also eligible at
+// a lane with thief_limit.
+bool limit_covers(int thief_limit, int victim_limit) {
+    return thief_limit == 0 || (victim_limit != 0 && victim_limit <= thief_limit);
+}
+
+void init_lane_classes() {
+    int lanes = total_lane_count();
+    int* limits = (int*)malloc(sizeof(int) * (lanes > 0 ? lanes : 1));
+    for (int i = 0; i < lanes; i++) limits[i] = all_lanes[i].max_items;
+    build_eligibility(&lane_eligibility, limits, lanes);
+    free(limits);
+}
+
+void run_express_comparison(int stores) {
+    WaitHistogram* with_express = (WaitHistogram*)malloc(sizeof(WaitHistogram));
+    WaitHistogram* without = (WaitHistogram*)malloc(sizeof(WaitHistogram));
+
+    int configured = express_lanes;
+    express_lanes = 0;
+    run_multi_store(stores, shard_threads, false, without);
+    express_lanes = configured;
+    run_multi_store(stores, shard_threads, false, with_express);
+
+    float p95_without = histogram_percentile_ms(without, 95.0f) / 1000.0f;
+    float p95_with = histogram_percentile_ms(with_express, 95.0f) / 1000.0f;
+    char label[64];
+    snprintf(label, sizeof(label), "%d express (<= %d items)%s", configured, express_item_limit,
+             kiosk_item_limit > 0 ? ", kiosks limited" : "");
+    printf("%-36s %10s  %9s  %8s  %8s\n", "lanes", "customers", "mean wait", "p95 wait", "max wait");
+    printf("%-36s %10lld  %7.2f s  %6.2f s  %6.2f s\n", "all lanes take any cart",
+           without->count, histogram_mean_ms(without) / 1000.0f, p95_without, without->max_ms / 1000.0f);
+    printf("%-36s %10lld  %7.2f s  %6.2f s  %6.2f s\n", label,
+           with_express->count, histogram_mean_ms(with_express) / 1000.0f, p95_with,
+           with_express->max_ms / 1000.0f);
+    printf("Express lanes change p95 wait by %+.2f s (%+.1f%%)\n", p95_with - p95_without,
+           p95_without > 0 ? (p95_with - p95_without) / p95_without * 100.0f : 0.0f);
+
+    free(with_express);
+    free(without);
+}
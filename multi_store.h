@@ -0,0 +1,142 @@
+#include "structs.h"
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+
+double wall_seconds() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+int online_cpu_count() {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    return cpus > 0 ? (int)cpus : 1;
+}
+
+void pin_current_thread(int cpu) {
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#endif
+}
+
+// Stores are created from the already-pinned shard thread so that, under the
+// kernel's first-touch policy, their pages live on that CPU's NUMA node.
+void* store_shard_function(void* arg) {
+    StoreShard* shard = (StoreShard*)arg;
+    pin_current_thread(shard->cpu);
+
+    shard->stores = (StoreSim**)malloc(sizeof(StoreSim*) * (shard->store_count > 0 ? shard->store_count : 1));
+    for (int i = 0; i < shard->store_count; i++) {
+        int id = shard->index + i * shard->thread_count;
+        shard->stores[i] = store_sim_create(id, id / stores_per_region, option_cashiers, option_kiosks, option_customers);
+    }
+    histogram_reset(&shard->waits);
+
+    double start = wall_seconds();
+    for (int i = 0; i < shard->store_count; i++) {
+        StoreSim* s = shard->stores[i];
+        if (sim_duration > 0) {
+            store_sim_advance(s, sim_duration);
+        } else {
+            store_sim_run(s);
+        }
+        histogram_merge(&shard->waits, &s->waits);
+        for (int k = 0; s->class_waits != NULL && k < priority_class_count; k++) {
+            histogram_merge(&shard->class_waits[k], &s->class_waits[k]);
+        }
+        shard->customers += s->served;
+        shard->balked += s->balked;
+        shard->reneged += s->reneged;
+        shard->events += s->events_processed;
+    }
+    shard->seconds = wall_seconds() - start;
+
+    for (int i = 0; i < shard->store_count; i++) {
+        store_sim_destroy(shard->stores[i]);
+    }
+    free(shard->stores);
+    return NULL;
+}
+
+double run_multi_store(int stores, int threads, bool verbose, WaitHistogram* waits_out) {
+    int cpus = online_cpu_count();
+    if (threads <= 0) threads = cpus;
+    if (threads > stores) threads = stores;
+
+    StoreShard* shards = (StoreShard*)calloc(threads, sizeof(StoreShard));
+    pthread_t* workers = (pthread_t*)malloc(sizeof(pthread_t) * threads);
+
+    double start = wall_seconds();
+    for (int t = 0; t < threads; t++) {
+        shards[t].index = t;
+        shards[t].thread_count = threads;
+        shards[t].cpu = t % cpus;
+        shards[t].store_count = stores / threads + (t < stores % threads ? 1 : 0);
+        pthread_create(&workers[t], NULL, store_shard_function, &shards[t]);
+    }
+
+    WaitHistogram* waits = (WaitHistogram*)malloc(sizeof(WaitHistogram));
+    WaitHistogram* class_totals = (WaitHistogram*)calloc(MAX_PRIORITY_CLASSES, sizeof(WaitHistogram));
+    histogram_reset(waits);
+    long long customers = 0;
+    long long balked = 0;
+    long long reneged = 0;
+    long long events = 0;
+    for (int t = 0; t < threads; t++) {
+        pthread_join(workers[t], NULL);
+        histogram_merge(waits, &shards[t].waits);
+        for (int k = 0; k < priority_class_count; k++) histogram_merge(&class_totals[k], &shards[t].class_waits[k]);
+        customers += shards[t].customers;
+        balked += shards[t].balked;
+        reneged += shards[t].reneged;
+        events += shards[t].events;
+    }
+    double elapsed = wall_seconds() - start;
+    double throughput = elapsed > 0 ? customers / elapsed : 0.0;
+
+    if (verbose) {
+        if (option_customers == INT_MAX) {
+            printf("Simulated %d stores (%d cashiers, %d kiosks, %.0f h of arrivals each) on %d threads in %.3f s\n",
+                   stores, option_cashiers, option_kiosks, arrival_horizon_hours, threads, elapsed);
+        } else {
+            printf("Simulated %d stores (%d cashiers, %d kiosks, %d customers each) on %d threads in %.3f s\n",
+                   stores, option_cashiers, option_kiosks, option_customers, threads, elapsed);
+        }
+        printf("Throughput: %.0f customers/s, %.0f events/s\n", throughput, elapsed > 0 ? events / elapsed : 0.0);
+        printf("Wait time over %lld customers: mean %.2f s, p95 %.2f s, max %.2f s\n",
+               waits->count, histogram_mean_ms(waits) / 1000.0f,
+               histogram_percentile_ms(waits, 95.0f) / 1000.0f, waits->max_ms / 1000.0f);
+        if (lane_capacity > 0 || patience_mean > 0) {
+            char summary[128];
+            format_abandonment(summary, sizeof(summary), customers + balked + reneged, balked, reneged);
+            printf("%s\n", summary);
+        }
+        if (priority_class_count > 1) print_class_waits("", class_totals);
+    }
+
+    if (waits_out != NULL) memcpy(waits_out, waits, sizeof(WaitHistogram));
+    free(class_totals);
+    free(waits);
+    free(workers);
+    free(shards);
+    return throughput;
+}
+
+void run_scaling_test(int stores) {
+    int cpus = online_cpu_count();
+    double baseline = 0.0;
+
+    printf("threads  customers/s  speedup  efficiency\n");
+    for (int threads = 1; ; threads = threads * 2 < cpus ? threads * 2 : cpus) {
+        double throughput = run_multi_store(stores, threads, false, NULL);
+        if (threads == 1) baseline = throughput;
+        double speedup = baseline > 0 ? throughput / baseline : 0.0;
+        printf("%7d  %11.0f  %7.2f  %9.0f%%\n", threads, throughput, speedup, speedup / threads * 100.0);
+        if (threads >= cpus) break;
+    }
+}
@@ -0,0 +1,164 @@
+#include "structs.h"
+#include <pthread.h>
+#include <stdlib.h>
+
+PatienceTimers patience_timers;
+pthread_mutex_t patience_lock = PTHREAD_MUTEX_INITIALIZER;
+int customers_balked = 0;
+int customers_reneged = 0;
+
+void timers_push(PatienceTimers* t, PatienceTimer timer) {
+    if (t->count == t->capacity) {
+        t->capacity = t->capacity > 0 ? t->capacity * 2 : 64;
+        t->items = (PatienceTimer*)realloc(t->items, sizeof(PatienceTimer) * t->capacity);
+    }
+    int i = t->count++;
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (t->items[parent].deadline <= timer.deadline) break;
+        t->items[i] = t->items[parent];
+        i = parent;
+    }
+    t->items[i] = timer;
+}
+
+PatienceTimer timers_pop(PatienceTimers* t) {
+    PatienceTimer top = t->items[0];
+    PatienceTimer last = t->items[--t->count];
+    int i = 0;
+    while (true) {
+        int child = 2 * i + 1;
+        if (child >= t->count) break;
+        if (child + 1 < t->count && t->items[child + 1].deadline < t->items[child].deadline) child++;
+        if (last.deadline <= t->items[child].deadline) break;
+        t->items[i] = t->items[child];
+        i = child;
+    }
+    if (t->count > 0) t->items[i] = last;
+    return top;
+}
+
+double timers_next(const PatienceTimers* t) {
+    return t->count > 0 ? t->items[0].deadline : DBL_MAX;
+}
+
+void timers_free(PatienceTimers* t) {
+    free(t->items);
+    t->items = NULL;
+    t->count = 0;
+    t->capacity = 0;
+}
+
+bool lane_full(int queued) {
+    return lane_capacity > 0 && queued >= lane_capacity;
+}
+
+void record_abandonment(bool reneged) {
+    pthread_mutex_lock(&customers_served_lock);
+    if (reneged) customers_reneged++;
+    else customers_balked++;
+    if (customers_served + customers_balked + customers_reneged >= total_customers) {
+        all_customers_served = 1;
+        simulation_end_time = sim_ticks();
+    }
+    pthread_mutex_unlock(&customers_served_lock);
+    request_redraw();
+}
+
+void schedule_patience(Customer* c) {
+    if (patience_mean <= 0) return;
+    double deadline = c->arrival_time + rng_exponential(&patience_rng, patience_mean) * 1000.0;
+    pthread_mutex_lock(&patience_lock);
+    timers_push(&patience_timers, (PatienceTimer){.deadline = deadline, .slot = c->slot, .id = c->id});
+    pthread_mutex_unlock(&patience_lock);
+}
+
+// The customer may have been served, stolen or moved since the deadline was
+// set; only one still waiting in its current lane leaves. Returns false when
+// the customer is still waiting but between two queues, so the timer must be
+// kept for them.
+bool renege_customer(Customer* c) {
+    pthread_mutex_lock(&visualization_lock);
+    int lane = c->lane_id - 1;
+    int line = c->line_id - 1;
+    pthread_mutex_unlock(&visualization_lock);
+
+    bool removed = false;
+    if (line >= 0) {
+        removed = shared_line_claim(&shared_lines[line], c);
+    } else if (lane >= 0) {
+        Queue* q = lane_queue(lane);
+        pthread_mutex_lock(&q->lock);
+        removed = remove_customer_locked(q, c);
+        pthread_mutex_unlock(&q->lock);
+    }
+    if (!removed) {
+        pthread_mutex_lock(&visualization_lock);
+        bool waiting = c->is_active && (c->visual_state == QUEUED || c->visual_state == MOVING_TO_QUEUE);
+        pthread_mutex_unlock(&visualization_lock);
+        return !waiting;
+    }
+
+    pthread_mutex_lock(&visualization_lock);
+    c->visual_state = LEAVING;
+    c->lane_id = 0;
+    c->ring_pinned = line >= 0;
+    c->line_id = 0;
+    pthread_mutex_unlock(&visualization_lock);
+    record_abandonment(true);
+    return true;
+}
+
+// Expired entries are collected first so no queue lock is taken while
+// holding patience_lock. Timers of customers caught between two queues go
+// back on the heap once this pass is over and fire again next frame.
+void expire_patience(Uint32 now) {
+    if (patience_mean <= 0) return;
+
+    PatienceTimer expired[64];
+    PatienceTimer* kept = NULL;
+    int kept_count = 0;
+    int count;
+    do {
+        count = 0;
+        pthread_mutex_lock(&patience_lock);
+        while (count < 64 && timers_next(&patience_timers) <= now) {
+            expired[count++] = timers_pop(&patience_timers);
+        }
+        pthread_mutex_unlock(&patience_lock);
+
+        for (int i = 0; i < count; i++) {
+            Customer* c = pool_customer(&customer_pool, expired[i].slot);
+            if (c->id != expired[i].id || renege_customer(c)) continue;
+            kept = (PatienceTimer*)realloc(kept, sizeof(PatienceTimer) * (kept_count + 1));
+            kept[kept_count++] = expired[i];
+        }
+    } while (count == 64);
+
+    pthread_mutex_lock(&patience_lock);
+    for (int i = 0; i < kept_count; i++) {
+        timers_push(&patience_timers, kept[i]);
+    }
+    pthread_mutex_unlock(&patience_lock);
+    free(kept);
+}
+
+Uint32 next_patience_deadline() {
+    pthread_mutex_lock(&patience_lock);
+    double next = timers_next(&patience_timers);
+    pthread_mutex_unlock(&patience_lock);
+    return next == DBL_MAX ? 0 : (Uint32)next;
+}
+
+void format_abandonment(char* buffer, size_t size, long long arrived, long long balked, long long reneged) {
+    snprintf(buffer, size, "Abandoned: %lld balked, %lld reneged (%.1f%% of %lld arrivals)",
+             balked, reneged, arrived > 0 ? (balked + reneged) * 100.0 / arrived : 0.0, arrived);
+}
+
+void print_abandonment_summary(int arrived) {
+    if (lane_capacity <= 0 && patience_mean <= 0) return;
+
+    char summary[128];
+    format_abandonment(summary, sizeof(summary), arrived, customers_balked, customers_reneged);
+    printf("%s\n", summary);
+}
@@ -0,0 +1,54 @@
+#include "structs.h"
+#include <pthread.h>
+#include <stdio.h>
+
+float priority_weights[MAX_PRIORITY_CLASSES] = {1.0f};
+float priority_weight_total = 1.0f;
+int priority_class_count = 1;
+WaitHistogram class_waits[MAX_PRIORITY_CLASSES];
+
+// Class 0 is served first. With a single class nothing is drawn, so runs
+// without a mix replay exactly as before.
+void init_priority_classes() {
+    int count = 0;
+    if (priority_mix_list != NULL) {
+        count = parse_float_list(priority_mix_list, priority_weights, MAX_PRIORITY_CLASSES);
+    }
+    priority_weight_total = 0.0f;
+    for (int k = 0; k < count; k++) {
+        if (priority_weights[k] < 0) priority_weights[k] = 0.0f;
+        priority_weight_total += priority_weights[k];
+    }
+    if (count <= 1 || priority_weight_total <= 0) {
+        count = 1;
+        priority_weights[0] = 1.0f;
+        priority_weight_total = 1.0f;
+    }
+    priority_class_count = count;
+}
+
+int draw_priority_class(RngStream* r) {
+    if (priority_class_count <= 1) return 0;
+    float u = rng_float(r) * priority_weight_total;
+    for (int k = 0; k < priority_class_count - 1; k++) {
+        u -= priority_weights[k];
+        if (u < 0) return k;
+    }
+    return priority_class_count - 1;
+}
+
+void print_class_waits(const char* indent, const WaitHistogram* waits) {
+    for (int k = 0; k < priority_class_count; k++) {
+        printf("%sClass %d: %lld customers, wait mean %.2f s, p95 %.2f s, max %.2f s\n",
+               indent, k, waits[k].count, histogram_mean_ms(&waits[k]) / 1000.0f,
+               histogram_percentile_ms(&waits[k], 95.0f) / 1000.0f, waits[k].max_ms / 1000.0f);
+    }
+}
+
+void print_priority_summary() {
+    if (priority_class_count <= 1) return;
+
+    pthread_mutex_lock(&wait_histogram_lock);
+    print_class_waits("", class_waits);
+    pthread_mutex_unlock(&wait_histogram_lock);
+}
@@ -0,0 +1,358 @@
+#include "structs.h"
+#include <pthread.h>
+#include <stdio.h>
+
+FinalReport final_report;
+bool final_report_ready = false;
+SDL_Texture* report_texture = NULL;
+TTF_Font* report_small_font = NULL;
+
+void compute_final_report() {
+    FinalReport* r = &final_report;
+    memset(r, 0, sizeof(FinalReport));
+    r->duration_ms = simulation_end_time - simulation_start_time;
+    r->fastest_cashier_speed = FLT_MAX;
+
+    for (int i = 0; i < cashier_count; i++) {
+        Lane* cashier = cashier_lane(i);
+        r->customers_processed += cashier->total_customers_served;
+        r->items_processed += cashier->total_items_processed;
+        r->stolen += cashier->customers_stolen;
+        if (cashier->avg_service_time_per_item < r->fastest_cashier_speed) {
+            r->fastest_cashier_speed = cashier->avg_service_time_per_item;
+            r->fastest_cashier_id = cashier->id;
+        }
+        if (cashier->avg_service_time_per_item > r->slowest_cashier_speed) {
+            r->slowest_cashier_speed = cashier->avg_service_time_per_item;
+            r->slowest_cashier_id = cashier->id;
+        }
+    }
+    for (int i = 0; i < selfcheckout_count; i++) r->stolen += kiosk_lane(i)->customers_stolen;
+    r->balked = customers_balked;
+    r->reneged = customers_reneged;
+    if (r->items_processed > 0) {
+        r->avg_time_per_item = (r->duration_ms / 1000.0f) / r->items_processed;
+    }
+
+    pthread_mutex_lock(&wait_histogram_lock);
+    r->wait_mean = histogram_mean_ms(&wait_histogram) / 1000.0f;
+    r->wait_p50 = histogram_percentile_ms(&wait_histogram, 50.0f) / 1000.0f;
+    r->wait_p95 = histogram_percentile_ms(&wait_histogram, 95.0f) / 1000.0f;
+    r->wait_p99 = histogram_percentile_ms(&wait_histogram, 99.0f) / 1000.0f;
+    r->wait_max = wait_histogram.max_ms / 1000.0f;
+    pthread_mutex_unlock(&wait_histogram_lock);
+    format_wait_summary(r->wait_summary, sizeof(r->wait_summary));
+}
+
+void write_report_csv(const char* path) {
+    FILE* f = fopen(path, "w");
+    if (f == NULL) {
+        perror(path);
+        return;
+    }
+    fprintf(f, "kind,id,seconds_per_item,customers_served,items_processed,avg_items_per_customer,customers_stolen,busy_seconds,max_items\n");
+    for (int i = 0; i < total_lane_count(); i++) {
+        Lane* c = &all_lanes[i];
+        fprintf(f, "%s,%d,%.3f,%d,%d,%.2f,%d,%.1f,%d\n", c->kind == CASHIER ? "cashier" : "kiosk",
+                c->id, c->avg_service_time_per_item,
+                c->total_customers_served, c->total_items_processed,
+                c->total_customers_served > 0 ? (float)c->total_items_processed / c->total_customers_served : 0.0f,
+                c->customers_stolen, c->busy_ms / 1000.0, c->max_items);
+    }
+    fclose(f);
+    printf("Wrote per-lane report to %s\n", path);
+}
+
+void write_report_json(const char* path, const FinalReport* r) {
+    FILE* f = fopen(path, "w");
+    if (f == NULL) {
+        perror(path);
+        return;
+    }
+    fprintf(f, "{\n  \"seed\": %llu,\n  \"replication\": %d,\n", (unsigned long long)simulation_seed, replication_id);
+    fprintf(f, "  \"duration_seconds\": %.3f,\n  \"customers\": %d,\n", r->duration_ms / 1000.0, total_customers);
+    fprintf(f, "  \"cashier_customers\": %d,\n  \"cashier_items\": %d,\n", r->customers_processed, r->items_processed);
+    fprintf(f, "  \"avg_time_per_item\": %.3f,\n  \"customers_stolen\": %d,\n", r->avg_time_per_item, r->stolen);
+    fprintf(f, "  \"customers_balked\": %d,\n  \"customers_reneged\": %d,\n", r->balked, r->reneged);
+    fprintf(f, "  \"wait_seconds\": {\"mean\": %.3f, \"p50\": %.3f, \"p95\": %.3f, \"p99\": %.3f, \"max\": %.3f},\n",
+            r->wait_mean, r->wait_p50, r->wait_p95, r->wait_p99, r->wait_max);
+    fprintf(f, "  \"lanes\": [");
+    for (int i = 0; i < total_lane_count(); i++) {
+        Lane* lane = &all_lanes[i];
+        fprintf(f, "%s\n    {\"kind\": \"%s\", \"id\": %d, \"seconds_per_item\": %.3f, \"customers_served\": %d, "
+                   "\"items_processed\": %d, \"busy_seconds\": %.1f}",
+                i > 0 ? "," : "", lane->kind == CASHIER ? "cashier" : "kiosk", lane->id, lane->avg_service_time_per_item,
+                lane->total_customers_served, lane->total_items_processed, lane->busy_ms / 1000.0);
+    }
+    fprintf(f, "\n  ]\n}\n");
+    fclose(f);
+    printf("Wrote report to %s\n", path);
+}
+
+void draw_final_report(const FinalReport* r) {
+    SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
+    SDL_RenderClear(renderer);
+    draw_header(r->duration_ms);
+    
+    char statsText[100];
+    sprintf(statsText, "SIMULATION COMPLETE - ALL CUSTOMERS SERVED IN %d SECONDS", (r->duration_ms / 1000));
+    SDL_Texture* completedTexture = renderText(renderer, font, statsText, (SDL_Color){0, 128, 0, 255});
+    SDL_Rect completedRect = {SCREEN_WIDTH / 2 - 350, 70, 700, 40};
+    SDL_RenderCopy(renderer, completedTexture, NULL, &completedRect);
+    SDL_DestroyTexture(completedTexture);
+    
+    int totalEntities = cashier_count + selfcheckout_count;
+    int availableHeight = SCREEN_HEIGHT - 220;
+    
+    TTF_Font* statFont = font;
+    int rowHeight = 40;
+    int statsPerColumn = 0;
+    int numColumns = 1;
+    
+    if (totalEntities > 10) {
+        if (report_small_font == NULL) report_small_font = TTF_OpenFont("arial.ttf", 18);
+        statFont = report_small_font ? report_small_font : font;
+        rowHeight = 30;
+    }
+    
+    statsPerColumn = availableHeight / rowHeight;
+    if (statsPerColumn < 1) statsPerColumn = 1;
+    
+    numColumns = (totalEntities + statsPerColumn - 1) / statsPerColumn;
+    if (numColumns < 1) numColumns = 1;
+    if (numColumns > 3) numColumns = 3; 
+    
+    int columnWidth = SCREEN_WIDTH / (numColumns + 1);
+    
+    const char* statsTitle = "CASHIER PERFORMANCE STATISTICS";
+    SDL_Texture* statsTitleTexture = renderText(renderer, font, statsTitle, (SDL_Color){0, 0, 0, 255});
+    SDL_Rect statsTitleRect = {SCREEN_WIDTH / 2 - 200, 120, 400, 30};
+    SDL_RenderCopy(renderer, statsTitleTexture, NULL, &statsTitleRect);
+    SDL_DestroyTexture(statsTitleTexture);
+    
+    const char* tableHeader = "Cashier ID | Service Speed | Customers Served | Items Processed | Avg Items/Customer";
+    SDL_Texture* headerTexture = renderText(renderer, statFont, tableHeader, (SDL_Color){50, 50, 50, 255});
+    SDL_Rect headerRect = {SCREEN_WIDTH / 2 - columnWidth/2, 160, columnWidth, 30};
+    SDL_RenderCopy(renderer, headerTexture, NULL, &headerRect);
+    SDL_DestroyTexture(headerTexture);
+    
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+    SDL_RenderDrawLine(renderer, SCREEN_WIDTH / 2 - columnWidth/2, 195, 
+                      SCREEN_WIDTH / 2 + columnWidth/2, 195);
+    
+    for (int col = 0; col < numColumns && col * statsPerColumn < cashier_count; col++) {
+        int startIndex = col * statsPerColumn;
+        int endIndex = startIndex + statsPerColumn;
+        if (endIndex > cashier_count) endIndex = cashier_count;
+        
+        int colX = (SCREEN_WIDTH / (numColumns + 1)) * (col + 1);
+        int yPos = 210;
+        
+        for (int i = startIndex; i < endIndex; i++) {
+            char cashierStatsText[200];
+            float avg_items_per_customer = 0;
+            if (cashier_lane(i)->total_customers_served > 0) {
+                avg_items_per_customer = (float)cashier_lane(i)->total_items_processed / cashier_lane(i)->total_customers_served;
+            }
+            
+            sprintf(cashierStatsText, "%5d      |   %.2f sec/item  |      %3d         |      %4d        |      %.1f", 
+                    cashier_lane(i)->id, 
+                    cashier_lane(i)->avg_service_time_per_item,
+                    cashier_lane(i)->total_customers_served,
+                    cashier_lane(i)->total_items_processed,
+                    avg_items_per_customer);
+                    
+            SDL_Texture* statsTexture = renderText(renderer, statFont, cashierStatsText, (SDL_Color){0, 0, 128, 255});
+            SDL_Rect statsRect = {colX - columnWidth/2, yPos, columnWidth, rowHeight};
+            SDL_RenderCopy(renderer, statsTexture, NULL, &statsRect);
+            SDL_DestroyTexture(statsTexture);
+            
+            yPos += rowHeight;
+        }
+    }
+    
+    if (selfcheckout_count > 0) {
+        int kioskStartY = 210 + ((cashier_count + numColumns - 1) / numColumns) * rowHeight + 30;
+        int yPos = kioskStartY;
+        
+        char kioskTitle[100];
+        sprintf(kioskTitle, "SELF-CHECKOUT KIOSK STATISTICS:");
+        SDL_Texture* kioskTitleTexture = renderText(renderer, statFont, kioskTitle, (SDL_Color){0, 0, 0, 255});
+        SDL_Rect kioskTitleRect = {SCREEN_WIDTH / 2 - 200, kioskStartY, 400, 30};
+        SDL_RenderCopy(renderer, kioskTitleTexture, NULL, &kioskTitleRect);
+        SDL_DestroyTexture(kioskTitleTexture);
+        kioskStartY += rowHeight;
+        
+        for (int col = 0; col < numColumns && col * statsPerColumn < selfcheckout_count; col++) {
+            int startIndex = col * statsPerColumn;
+            int endIndex = startIndex + statsPerColumn;
+            if (endIndex > selfcheckout_count) endIndex = selfcheckout_count;
+            
+            int colX = (SCREEN_WIDTH / (numColumns + 1)) * (col + 1);
+            int yPos = kioskStartY;
+            
+            for (int i = startIndex; i < endIndex; i++) {
+                char kioskStatsText[200];
+                float avg_items_per_customer = 0;
+                if (kiosk_lane(i)->total_customers_served > 0) {
+                    avg_items_per_customer = (float)kiosk_lane(i)->total_items_processed / kiosk_lane(i)->total_customers_served;
+                }
+                
+                sprintf(kioskStatsText, "Kiosk %d: %d customers, %d items (%.1f items/customer), %.1f sec/item", 
+                        kiosk_lane(i)->id, 
+                        kiosk_lane(i)->total_customers_served,
+                        kiosk_lane(i)->total_items_processed,
+                        avg_items_per_customer,
+                        kiosk_lane(i)->avg_service_time_per_item);
+                        
+                SDL_Texture* statsTexture = renderText(renderer, statFont, kioskStatsText, (SDL_Color){0, 0, 128, 255});
+                SDL_Rect statsRect = {colX - columnWidth/2, yPos, columnWidth, rowHeight};
+                SDL_RenderCopy(renderer, statsTexture, NULL, &statsRect);
+                SDL_DestroyTexture(statsTexture);
+                
+                yPos += rowHeight;
+            }
+        }
+        
+        yPos = kioskStartY + ((selfcheckout_count + numColumns - 1) / numColumns) * rowHeight + 20;
+        
+        SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+        SDL_RenderDrawLine(renderer, SCREEN_WIDTH / 2 - 400, yPos, SCREEN_WIDTH / 2 + 400, yPos);
+        yPos += 30;
+        
+        char summaryTitle[100];
+        sprintf(summaryTitle, "SUMMARY STATISTICS:");
+        SDL_Texture* summaryTitleTexture = renderText(renderer, statFont, summaryTitle, (SDL_Color){0, 0, 0, 255});
+        SDL_Rect summaryTitleRect = {SCREEN_WIDTH / 2 - 200, yPos, 400, rowHeight-10};
+        SDL_RenderCopy(renderer, summaryTitleTexture, NULL, &summaryTitleRect);
+        SDL_DestroyTexture(summaryTitleTexture);
+        yPos += rowHeight;
+        
+        if (yPos + 4*rowHeight < SCREEN_HEIGHT - 60) {
+            char fastestCashier[100];
+            sprintf(fastestCashier, "Fastest Cashier: #%d (%.2f sec/item)", r->fastest_cashier_id, r->fastest_cashier_speed);
+            SDL_Texture* fastestTexture = renderText(renderer, statFont, fastestCashier, (SDL_Color){0, 128, 0, 255});
+            SDL_Rect fastestRect = {SCREEN_WIDTH / 2 - 200, yPos, 400, rowHeight-10};
+            SDL_RenderCopy(renderer, fastestTexture, NULL, &fastestRect);
+            SDL_DestroyTexture(fastestTexture);
+            yPos += rowHeight;
+            
+            char slowestCashier[100];
+            sprintf(slowestCashier, "Slowest Cashier: #%d (%.2f sec/item)", r->slowest_cashier_id, r->slowest_cashier_speed);
+            SDL_Texture* slowestTexture = renderText(renderer, statFont, slowestCashier, (SDL_Color){128, 0, 0, 255});
+            SDL_Rect slowestRect = {SCREEN_WIDTH / 2 - 200, yPos, 400, rowHeight-10};
+            SDL_RenderCopy(renderer, slowestTexture, NULL, &slowestRect);
+            SDL_DestroyTexture(slowestTexture);
+            yPos += rowHeight;
+            
+            char avgServiceTime[100];
+            sprintf(avgServiceTime, "Average Time Per Item: %.2f seconds", r->avg_time_per_item);
+            SDL_Texture* avgTimeTexture = renderText(renderer, statFont, avgServiceTime, (SDL_Color){0, 0, 0, 255});
+            SDL_Rect avgTimeRect = {SCREEN_WIDTH / 2 - 200, yPos, 400, rowHeight-10};
+            SDL_RenderCopy(renderer, avgTimeTexture, NULL, &avgTimeRect);
+            SDL_DestroyTexture(avgTimeTexture);
+            yPos += rowHeight;
+            
+            SDL_Texture* waitTexture = renderText(renderer, statFont, r->wait_summary, (SDL_Color){0, 0, 0, 255});
+            SDL_Rect waitRect = {SCREEN_WIDTH / 2 - 300, yPos, 600, rowHeight-10};
+            SDL_RenderCopy(renderer, waitTexture, NULL, &waitRect);
+            SDL_DestroyTexture(waitTexture);
+        }
+    } else {
+        int summaryY = 210 + (cashier_count * rowHeight) + 30;
+        
+        SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+        SDL_RenderDrawLine(renderer, SCREEN_WIDTH / 2 - 400, summaryY, SCREEN_WIDTH / 2 + 400, summaryY);
+        summaryY += 30;
+        
+        char summaryTitle[100];
+        sprintf(summaryTitle, "SUMMARY STATISTICS:");
+        SDL_Texture* summaryTitleTexture = renderText(renderer, statFont, summaryTitle, (SDL_Color){0, 0, 0, 255});
+        SDL_Rect summaryTitleRect = {SCREEN_WIDTH / 2 - 200, summaryY, 400, rowHeight-10};
+        SDL_RenderCopy(renderer, summaryTitleTexture, NULL, &summaryTitleRect);
+        SDL_DestroyTexture(summaryTitleTexture);
+        summaryY += rowHeight;
+        
+        if (summaryY + 4*rowHeight < SCREEN_HEIGHT - 60) {
+            char fastestCashier[100];
+            sprintf(fastestCashier, "Fastest Cashier: #%d (%.2f sec/item)", r->fastest_cashier_id, r->fastest_cashier_speed);
+            SDL_Texture* fastestTexture = renderText(renderer, statFont, fastestCashier, (SDL_Color){0, 128, 0, 255});
+            SDL_Rect fastestRect = {SCREEN_WIDTH / 2 - 200, summaryY, 400, rowHeight-10};
+            SDL_RenderCopy(renderer, fastestTexture, NULL, &fastestRect);
+            SDL_DestroyTexture(fastestTexture);
+            summaryY += rowHeight;
+            
+            char slowestCashier[100];
+            sprintf(slowestCashier, "Slowest Cashier: #%d (%.2f sec/item)", r->slowest_cashier_id, r->slowest_cashier_speed);
+            SDL_Texture* slowestTexture = renderText(renderer, statFont, slowestCashier, (SDL_Color){128, 0, 0, 255});
+            SDL_Rect slowestRect = {SCREEN_WIDTH / 2 - 200, summaryY, 400, rowHeight-10};
+            SDL_RenderCopy(renderer, slowestTexture, NULL, &slowestRect);
+            SDL_DestroyTexture(slowestTexture);
+            summaryY += rowHeight;
+            
+            char avgServiceTime[100];
+            sprintf(avgServiceTime, "Average Time Per Item: %.2f seconds", r->avg_time_per_item);
+            SDL_Texture* avgTimeTexture = renderText(renderer, statFont, avgServiceTime, (SDL_Color){0, 0, 0, 255});
+            SDL_Rect avgTimeRect = {SCREEN_WIDTH / 2 - 200, summaryY, 400, rowHeight-10};
+            SDL_RenderCopy(renderer, avgTimeTexture, NULL, &avgTimeRect);
+            SDL_DestroyTexture(avgTimeTexture);
+            summaryY += rowHeight;
+            
+            SDL_Texture* waitTexture = renderText(renderer, statFont, r->wait_summary, (SDL_Color){0, 0, 0, 255});
+            SDL_Rect waitRect = {SCREEN_WIDTH / 2 - 300, summaryY, 600, rowHeight-10};
+            SDL_RenderCopy(renderer, waitTexture, NULL, &waitRect);
+            SDL_DestroyTexture(waitTexture);
+        }
+    }
+    
+    const char* closingNote = "Close this window to exit the simulation.";
+    SDL_Texture* noteTexture = renderText(renderer, font, closingNote, (SDL_Color){100, 100, 100, 255});
+    int noteWidth, noteHeight;
+    SDL_QueryTexture(noteTexture, NULL, NULL, &noteWidth, &noteHeight);
+    SDL_Rect noteRect = {SCREEN_WIDTH / 2 - noteWidth/2, SCREEN_HEIGHT - 40, noteWidth, 30};
+    SDL_RenderCopy(renderer, noteTexture, NULL, &noteRect);
+    SDL_DestroyTexture(noteTexture);
+
+}
+
+// Runs once, whether the run ends with every customer served or is stopped
+// early by the duration limit or by closing the window.
+void export_final_report() {
+    if (final_report_ready) return;
+    compute_final_report();
+    final_report_ready = true;
+    if (report_csv_path != NULL) write_report_csv(report_csv_path);
+    if (report_json_path != NULL) write_report_json(report_json_path, &final_report);
+}
+
+// The report is drawn once into a target texture; later frames only copy it.
+// Renderers without render-target support fall back to redrawing from the
+// stored numbers.
+void show_final_report() {
+    if (!final_report_ready) {
+        export_final_report();
+
+        report_texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET,
+                                           SCREEN_WIDTH, SCREEN_HEIGHT);
+        if (report_texture != NULL && SDL_SetRenderTarget(renderer, report_texture) == 0) {
+            draw_final_report(&final_report);
+            SDL_SetRenderTarget(renderer, NULL);
+        } else if (report_texture != NULL) {
+            SDL_DestroyTexture(report_texture);
+            report_texture = NULL;
+        }
+    }
+
+    if (report_texture != NULL) {
+        SDL_RenderCopy(renderer, report_texture, NULL, NULL);
+    } else {
+        draw_final_report(&final_report);
+    }
+}
+
+void free_final_report() {
+    if (report_texture) SDL_DestroyTexture(report_texture);
+    if (report_small_font) TTF_CloseFont(report_small_font);
+    report_texture = NULL;
+    report_small_font = NULL;
+}
@@ -0,0 +1,90 @@
+#include "structs.h"
+#include <stdint.h>
+#include <math.h>
+
+RngStream arrival_rng;
+RngStream customer_rng;
+RngStream patience_rng;
+RngStream class_rng;
+
+uint64_t splitmix64(uint64_t* x) {
+    uint64_t z = (*x += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+uint32_t rng_next_u32(RngStream* r) {
+    uint64_t old = r->state;
+    r->state = old * 6364136223846793005ULL + r->inc;
+    uint32_t xorshifted = (uint32_t)(((old >> 18) ^ old) >> 27);
+    uint32_t rot = (uint32_t)(old >> 59);
+    return (xorshifted >> rot) | (xorshifted << ((-rot) & 31));
+}
+
+// PCG32 stream: the seed picks the position, the (kind, index) pair picks the
+// increment, so every lane / process / replication gets its own sequence.
+void rng_seed(RngStream* r, uint64_t seed, int replication, RngStreamKind kind, int index) {
+    uint64_t mix = seed ^ ((uint64_t)replication << 32);
+    uint64_t init_state = splitmix64(&mix);
+    uint64_t selector = ((uint64_t)kind << 40) ^ (uint64_t)(uint32_t)index ^ ((uint64_t)replication << 48);
+
+    r->state = 0;
+    r->inc = (splitmix64(&selector) << 1) | 1u;
+    rng_next_u32(r);
+    r->state += init_state;
+    rng_next_u32(r);
+}
+
+uint32_t rng_bounded(RngStream* r, uint32_t bound) {
+    uint64_t m = (uint64_t)rng_next_u32(r) * bound;
+    uint32_t low = (uint32_t)m;
+    if (low < bound) {
+        uint32_t threshold = (0u - bound) % bound;
+        while (low < threshold) {
+            m = (uint64_t)rng_next_u32(r) * bound;
+            low = (uint32_t)m;
+        }
+    }
+    return (uint32_t)(m >> 32);
+}
+
+int rng_range(RngStream* r, int min, int max) {
+    return min + (int)rng_bounded(r, (uint32_t)(max - min + 1));
+}
+
+float rng_float(RngStream* r) {
+    return (rng_next_u32(r) >> 8) * (1.0f / 16777216.0f);
+}
+
+float rng_exponential(RngStream* r, float mean) {
+    float u = ((rng_next_u32(r) >> 8) + 1) * (1.0f / 16777217.0f);
+    return -mean * logf(u);
+}
+
+float rng_normal(RngStream* r) {
+    float u1 = ((rng_next_u32(r) >> 8) + 1) * (1.0f / 16777217.0f);
+    float u2 = rng_float(r);
+    return sqrtf(-2.0f * logf(u1)) * cosf(6.28318530718f * u2);
+}
+
+void rng_fill_range(RngStream* r, int* out, int n, int min, int max) {
+    uint32_t bound = (uint32_t)(max - min + 1);
+    for (int i = 0; i < n; i++) {
+        out[i] = min + (int)rng_bounded(r, bound);
+    }
+}
+
+void rng_fill_gaps_ms(RngStream* r, Uint32* out, int n, Uint32 min_ms, Uint32 max_ms) {
+    uint32_t bound = max_ms - min_ms + 1;
+    for (int i = 0; i < n; i++) {
+        out[i] = min_ms + rng_bounded(r, bound);
+    }
+}
+
+void init_rng_streams() {
+    rng_seed(&arrival_rng, simulation_seed, replication_id, STREAM_ARRIVALS, 0);
+    rng_seed(&customer_rng, simulation_seed, replication_id, STREAM_CUSTOMERS, 0);
+    rng_seed(&patience_rng, simulation_seed, replication_id, STREAM_PATIENCE, 0);
+    rng_seed(&class_rng, simulation_seed, replication_id, STREAM_PRIORITY, 0);
+}
@@ -0,0 +1,142 @@
+#include "structs.h"
+#include <pthread.h>
+#include <string.h>
+
+RngStream routing_rng;
+int round_robin_next = 0;
+long long routing_decisions = 0;
+Uint64 routing_cost_ticks = 0;
+
+// An open lane in a shared line counts its share of the customers in the
+// line.
+int lane_queue_length(int lane) {
+    Queue* q = lane_queue(lane);
+    pthread_mutex_lock(&q->lock);
+    int length = q->size;
+    pthread_mutex_unlock(&q->lock);
+
+    SharedLine* line = all_lanes[lane].line;
+    if (line != NULL && all_lanes[lane].status == LANE_OPEN) {
+        int servers = shared_line_servers(line);
+        length += (shared_line_length(line) + servers - 1) / servers;
+    }
+    return length + (all_lanes[lane].is_serving ? 1 : 0);
+}
+
+Lane* route_least_work(Customer* customer) {
+    return get_best_lane(customer);
+}
+
+Lane* route_shortest_queue(Customer* customer) {
+    int lanes = total_lane_count();
+    int best_length = INT_MAX;
+    int best_lane = -1;
+
+    for (int lane = 0; lane < lanes; lane++) {
+        if (!lane_accepts_customers(lane) || !lane_eligible(&lane_eligibility, lane, customer->items)) continue;
+        int length = lane_queue_length(lane);
+        if (length < best_length) {
+            best_length = length;
+            best_lane = lane;
+        }
+    }
+
+    if (best_lane < 0) return get_best_lane(customer);
+    return &all_lanes[best_lane];
+}
+
+Lane* route_power_of_d(Customer* customer) {
+    int lanes = total_lane_count();
+    float best_score = FLT_MAX;
+    int best_lane = -1;
+
+    for (int draw = 0, tries = 0; draw < routing_choices && tries < routing_choices * 4; tries++) {
+        int lane = (int)rng_bounded(&routing_rng, (uint32_t)lanes);
+        if (!lane_accepts_customers(lane) || !lane_eligible(&lane_eligibility, lane, customer->items)) continue;
+        draw++;
+        float score = lane_score(&all_lanes[lane], customer);
+        if (score < best_score) {
+            best_score = score;
+            best_lane = lane;
+        }
+    }
+
+    if (best_lane < 0) return get_best_lane(customer);
+    return &all_lanes[best_lane];
+}
+
+Lane* route_round_robin(Customer* customer) {
+    int lanes = total_lane_count();
+
+    for (int tries = 0; tries < lanes; tries++) {
+        int lane = round_robin_next;
+        round_robin_next = (round_robin_next + 1) % lanes;
+        if (lane_accepts_customers(lane) && lane_eligible(&lane_eligibility, lane, customer->items)) {
+            return &all_lanes[lane];
+        }
+    }
+    return get_best_lane(customer);
+}
+
+Lane* route_item_threshold(Customer* customer) {
+    CheckoutType wanted = customer->items <= kiosk_item_threshold ? KIOSK : CASHIER;
+    float best_score = FLT_MAX;
+    Lane* best = NULL;
+
+    for (int lane = 0; lane < total_lane_count(); lane++) {
+        if (all_lanes[lane].kind != wanted || !lane_accepts_customers(lane)) continue;
+        if (!lane_eligible(&lane_eligibility, lane, customer->items)) continue;
+        float score = lane_score(&all_lanes[lane], customer);
+        if (score < best_score) {
+            best_score = score;
+            best = &all_lanes[lane];
+        }
+    }
+
+    if (best == NULL) return get_best_lane(customer);
+    return best;
+}
+
+RoutingPolicy routing_policies[] = {
+    {"least_work", route_least_work},
+    {"jsq", route_shortest_queue},
+    {"power_of_d", route_power_of_d},
+    {"round_robin", route_round_robin},
+    {"item_threshold", route_item_threshold},
+};
+
+RoutingPolicy* active_routing_policy = &routing_policies[0];
+
+bool select_routing_policy(const char* name) {
+    int count = sizeof(routing_policies) / sizeof(routing_policies[0]);
+    for (int i = 0; i < count; i++) {
+        if (strcmp(routing_policies[i].name, name) == 0) {
+            active_routing_policy = &routing_policies[i];
+            return true;
+        }
+    }
+    return false;
+}
+
+void init_routing() {
+    rng_seed(&routing_rng, simulation_seed, replication_id, STREAM_ROUTING, 0);
+    if (!select_routing_policy(routing_policy_name)) {
+        printf("Unknown routing policy '%s', using %s\n", routing_policy_name, routing_policies[0].name);
+        active_routing_policy = &routing_policies[0];
+    }
+}
+
+Lane* choose_checkout(Customer* customer) {
+    Uint64 start = SDL_GetPerformanceCounter();
+    Lane* lane = active_routing_policy->choose(customer);
+    routing_cost_ticks += SDL_GetPerformanceCounter() - start;
+    routing_decisions++;
+    return lane;
+}
+
+void print_routing_summary() {
+    double total_us = routing_cost_ticks * 1000000.0 / SDL_GetPerformanceFrequency();
+    printf("Routing policy %s: %lld decisions, %.2f us per decision\n",
+           active_routing_policy->name, routing_decisions,
+           routing_decisions > 0 ? total_us / routing_decisions : 0.0);
+}
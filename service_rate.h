@@ -0,0 +1,79 @@
+#include "structs.h"
+#include <math.h>
+
+#define ESTIMATE_CONVERGED_ERROR 0.10f
+
+// The draw is taken even when the speed is configured so the lane's stream
+// stays aligned with unconfigured runs.
+float initial_cashier_speed(int index, RngStream* r) {
+    float speed = 0.5f + rng_float(r);
+    return index < cashier_speed_count ? cashier_speeds[index] : speed;
+}
+
+void init_service_estimate(ServiceEstimate* e, float prior) {
+    e->seconds_per_item = prior;
+    e->observed_items = 0.0f;
+    e->observations = 0;
+    e->converged_after = -1;
+}
+
+// Until the observed items outweigh the prior this is the Bayesian posterior
+// mean; afterwards the gain bottoms out at the EWMA rate so it keeps tracking.
+void observe_service(ServiceEstimate* e, int items, Uint32 service_ms, float true_seconds_per_item) {
+    if (items <= 0) return;
+
+    float observed = (service_ms / 1000.0f) / items;
+    e->observed_items += items;
+    float gain = items / (service_prior_items + e->observed_items);
+    if (gain < service_ewma_rate) gain = service_ewma_rate;
+    e->seconds_per_item += gain * (observed - e->seconds_per_item);
+    e->observations++;
+
+    float error = fabsf(e->seconds_per_item - true_seconds_per_item) / true_seconds_per_item;
+    if (e->converged_after < 0 && error <= ESTIMATE_CONVERGED_ERROR) {
+        e->converged_after = e->observations;
+    }
+}
+
+float lane_routing_speed(Lane* lane) {
+    if (learn_service_rates) return lane->estimate.seconds_per_item;
+    return lane->avg_service_time_per_item;
+}
+
+Uint32 draw_service_ms(RngStream* rng, float seconds_per_item, int items) {
+    float service_time = seconds_per_item * items;
+    if (service_time_noise > 0.0f) {
+        service_time *= expf(service_time_noise * rng_normal(rng) - 0.5f * service_time_noise * service_time_noise);
+    }
+    return (Uint32)(service_time * 1000);
+}
+
+void print_estimate_line(const char* kind, int id, float truth, const ServiceEstimate* e) {
+    printf("  %s %d: true %.2f s/item, learned %.2f s/item (%+.1f%%) from %d customers",
+           kind, id, truth, e->seconds_per_item,
+           (e->seconds_per_item - truth) / truth * 100.0f, e->observations);
+    if (e->converged_after < 0) {
+        printf(", not yet within %.0f%%\n", ESTIMATE_CONVERGED_ERROR * 100.0f);
+    } else {
+        printf(", within %.0f%% after %d\n", ESTIMATE_CONVERGED_ERROR * 100.0f, e->converged_after);
+    }
+}
+
+void print_learning_summary() {
+    if (!learn_service_rates) return;
+
+    float total_error = 0.0f;
+    int lanes = 0;
+
+    printf("Learned service rates (priors: cashier %.2f, kiosk %.2f s/item, %.0f prior items):\n",
+           cashier_speed_prior, kiosk_speed_prior, service_prior_items);
+    for (int i = 0; i < total_lane_count(); i++) {
+        Lane* lane = &all_lanes[i];
+        print_estimate_line(lane->kind == CASHIER ? "Cashier" : "Kiosk", lane->id, lane->avg_service_time_per_item, &lane->estimate);
+        total_error += fabsf(lane->estimate.seconds_per_item - lane->avg_service_time_per_item) / lane->avg_service_time_per_item;
+        lanes++;
+    }
+    if (lanes > 0) {
+        printf("  Mean absolute error: %.1f%%\n", total_error / lanes * 100.0f);
+    }
+}
@@ -0,0 +1,352 @@
+#include "structs.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Only live state is written: queued customers in order, pending events and
+// patience timers, the unread part of the arrival and cart buffers and the
+// used prefix of the wait histogram.
+bool write_store_snapshot(FILE* f, StoreSim* s) {
+    SnapshotStore record;
+    memset(&record, 0, sizeof(record));
+    record.id = s->id;
+    record.region = s->region;
+    record.cashier_count = s->cashier_count;
+    record.kiosk_count = s->kiosk_count;
+    record.event_count = s->event_count;
+    record.total_customers = s->total_customers;
+    record.initial_burst = s->initial_burst;
+    record.arrived = s->arrived;
+    record.served = s->served;
+    record.balked = s->balked;
+    record.reneged = s->reneged;
+    record.timer_count = s->timers.count;
+    record.arrivals_pending = s->arrival_count - s->arrival_next;
+    record.carts_pending = ARRIVAL_BATCH - s->cart_next;
+    record.events_processed = s->events_processed;
+    record.clock = s->clock;
+    record.next_arrival = s->next_arrival;
+    record.arrival_clock = s->arrival_clock;
+    record.arrival_horizon = s->arrival_horizon;
+    record.arrival_rng = s->arrival_rng;
+    record.customer_rng = s->customer_rng;
+    record.patience_rng = s->patience_rng;
+    record.class_rng = s->class_rng;
+    record.priority_classes = s->class_waits != NULL ? priority_class_count : 0;
+    record.line_count = s->line_count;
+    record.wait_count = s->waits.count;
+    record.wait_total_ms = s->waits.total_ms;
+    record.wait_max_ms = s->waits.max_ms;
+
+    int buckets = WAIT_HISTOGRAM_BUCKETS + 1;
+    while (buckets > 0 && s->waits.counts[buckets - 1] == 0) buckets--;
+    record.histogram_buckets = buckets;
+
+    int queues = s->lane_count + s->line_count;
+    bool ok = fwrite(&record, sizeof(record), 1, f) == 1;
+    ok = ok && fwrite(s->lanes, sizeof(SimLane), queues, f) == (size_t)queues;
+    for (int i = 0; ok && i < queues; i++) {
+        SimLane* lane = &s->lanes[i];
+        for (int k = 0; ok && k < lane->count; k++) {
+            ok = fwrite(&lane->ring[(lane->head + k) % lane->capacity], sizeof(SimCustomer), 1, f) == 1;
+        }
+    }
+    ok = ok && fwrite(s->events, sizeof(SimEvent), s->event_count, f) == (size_t)s->event_count;
+    ok = ok && fwrite(s->timers.items, sizeof(PatienceTimer), s->timers.count, f) == (size_t)s->timers.count;
+    ok = ok && fwrite(s->arrival_buffer + s->arrival_next, sizeof(double), record.arrivals_pending, f) ==
+                   (size_t)record.arrivals_pending;
+    ok = ok && fwrite(s->cart_buffer + s->cart_next, sizeof(int), record.carts_pending, f) ==
+                   (size_t)record.carts_pending;
+    ok = ok && fwrite(s->waits.counts, sizeof(int), buckets, f) == (size_t)buckets;
+    ok = ok && fwrite(s->class_waits, sizeof(WaitHistogram), record.priority_classes, f) ==
+                   (size_t)record.priority_classes;
+    return ok;
+}
+
+bool save_snapshot(const char* path, StoreSim** stores, int count, double clock) {
+    FILE* f = fopen(path, "wb");
+    if (f == NULL) {
+        perror(path);
+        return false;
+    }
+
+    SnapshotHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.store_count = count;
+    header.nhpp_arrivals = !uniform_arrivals();
+    header.seed = simulation_seed;
+    header.replication = replication_id;
+    header.clock = clock;
+
+    bool ok = fwrite(&header, sizeof(header), 1, f) == 1;
+    for (int i = 0; ok && i < count; i++) {
+        ok = write_store_snapshot(f, stores[i]);
+    }
+    if (fclose(f) != 0) ok = false;
+    if (!ok) printf("Failed to write snapshot %s\n", path);
+    return ok;
+}
+
+const void* snapshot_take(const char** cursor, const char* end, size_t size) {
+    if ((size_t)(end - *cursor) < size) return NULL;
+    const void* p = *cursor;
+    *cursor += size;
+    return p;
+}
+
+StoreSim* restore_store(const char** cursor, const char* end) {
+    const SnapshotStore* record = (const SnapshotStore*)snapshot_take(cursor, end, sizeof(SnapshotStore));
+    if (record == NULL) return NULL;
+
+    StoreSim* s = (StoreSim*)calloc(1, sizeof(StoreSim));
+    s->id = record->id;
+    s->region = record->region;
+    s->cashier_count = record->cashier_count;
+    s->kiosk_count = record->kiosk_count;
+    s->lane_count = record->cashier_count + record->kiosk_count;
+    s->line_count = record->line_count >= 0 && record->line_count <= MAX_SHARED_LINES ? record->line_count : 0;
+    s->event_count = record->event_count;
+    s->total_customers = record->total_customers;
+    s->initial_burst = record->initial_burst;
+    s->arrived = record->arrived;
+    s->served = record->served;
+    s->balked = record->balked;
+    s->reneged = record->reneged;
+    s->events_processed = record->events_processed;
+    s->clock = record->clock;
+    s->next_arrival = record->next_arrival;
+    s->arrival_clock = record->arrival_clock;
+    s->arrival_horizon = record->arrival_horizon;
+    s->arrival_rng = record->arrival_rng;
+    s->customer_rng = record->customer_rng;
+    s->patience_rng = record->patience_rng;
+    s->class_rng = record->class_rng;
+
+    int queues = s->lane_count + s->line_count;
+    s->lanes = (SimLane*)calloc(queues > 0 ? queues : 1, sizeof(SimLane));
+    s->events = (SimEvent*)malloc(sizeof(SimEvent) * (s->lane_count > 0 ? s->lane_count : 1));
+    histogram_reset(&s->waits);
+
+    const void* lanes = snapshot_take(cursor, end, sizeof(SimLane) * queues);
+    bool ok = lanes != NULL && s->event_count <= s->lane_count && record->line_count == s->line_count &&
+              record->arrivals_pending >= 0 && record->arrivals_pending <= ARRIVAL_BATCH &&
+              record->carts_pending >= 0 && record->carts_pending <= ARRIVAL_BATCH &&
+              record->histogram_buckets >= 0 && record->histogram_buckets <= WAIT_HISTOGRAM_BUCKETS + 1 &&
+              record->timer_count >= 0 && record->priority_classes >= 0 &&
+              record->priority_classes <= MAX_PRIORITY_CLASSES;
+    if (ok) memcpy(s->lanes, lanes, sizeof(SimLane) * queues);
+
+    int* limits = (int*)malloc(sizeof(int) * (queues > 0 ? queues : 1));
+    for (int i = 0; i < queues; i++) {
+        SimLane* lane = &s->lanes[i];
+        int count = ok ? lane->count : 0;
+        lane->capacity = SIM_INITIAL_LANE_CAPACITY;
+        while (lane->capacity < count) lane->capacity *= 2;
+        lane->ring = (SimCustomer*)malloc(sizeof(SimCustomer) * lane->capacity);
+        lane->head = 0;
+        lane->count = count;
+
+        const void* queued = ok ? snapshot_take(cursor, end, sizeof(SimCustomer) * count) : NULL;
+        if (queued == NULL && count > 0) ok = false;
+        if (ok && count > 0) memcpy(lane->ring, queued, sizeof(SimCustomer) * count);
+        if (lane->line < 0 || lane->line >= queues || lane->members < 1) ok = false;
+        limits[i] = lane->max_items;
+    }
+    build_eligibility(&s->eligibility, limits, s->lane_count);
+    if (ok) sim_build_route(s);
+    free(limits);
+
+    const void* events = ok ? snapshot_take(cursor, end, sizeof(SimEvent) * s->event_count) : NULL;
+    const void* timers = ok ? snapshot_take(cursor, end, sizeof(PatienceTimer) * record->timer_count) : NULL;
+    const void* arrivals = ok ? snapshot_take(cursor, end, sizeof(double) * record->arrivals_pending) : NULL;
+    const void* carts = ok ? snapshot_take(cursor, end, sizeof(int) * record->carts_pending) : NULL;
+    const void* counts = ok ? snapshot_take(cursor, end, sizeof(int) * record->histogram_buckets) : NULL;
+    const void* classes = ok ? snapshot_take(cursor, end, sizeof(WaitHistogram) * record->priority_classes) : NULL;
+    if (events == NULL || timers == NULL || arrivals == NULL || carts == NULL || counts == NULL || classes == NULL) {
+        store_sim_destroy(s);
+        return NULL;
+    }
+
+    memcpy(s->events, events, sizeof(SimEvent) * s->event_count);
+    s->timers.capacity = record->timer_count;
+    s->timers.count = record->timer_count;
+    s->timers.items = (PatienceTimer*)malloc(sizeof(PatienceTimer) * (record->timer_count > 0 ? record->timer_count : 1));
+    memcpy(s->timers.items, timers, sizeof(PatienceTimer) * record->timer_count);
+    s->arrival_count = ARRIVAL_BATCH;
+    s->arrival_next = ARRIVAL_BATCH - record->arrivals_pending;
+    memcpy(s->arrival_buffer + s->arrival_next, arrivals, sizeof(double) * record->arrivals_pending);
+    s->cart_next = ARRIVAL_BATCH - record->carts_pending;
+    memcpy(s->cart_buffer + s->cart_next, carts, sizeof(int) * record->carts_pending);
+    memcpy(s->waits.counts, counts, sizeof(int) * record->histogram_buckets);
+    s->waits.count = record->wait_count;
+    s->waits.total_ms = record->wait_total_ms;
+    s->waits.max_ms = record->wait_max_ms;
+    if (priority_class_count > 1) {
+        s->class_waits = (WaitHistogram*)calloc(priority_class_count, sizeof(WaitHistogram));
+        int kept = record->priority_classes < priority_class_count ? record->priority_classes : priority_class_count;
+        memcpy(s->class_waits, classes, sizeof(WaitHistogram) * kept);
+    }
+    return s;
+}
+
+// A branch restored under a different replication keeps everything that has
+// already happened but draws a fresh future: new streams, and the next arrival
+// and buffered carts are resampled from the restored clock.
+void branch_store(StoreSim* s, int replication) {
+    rng_seed(&s->arrival_rng, simulation_seed, replication, STREAM_ARRIVALS, s->region);
+    rng_seed(&s->customer_rng, simulation_seed, replication, STREAM_CUSTOMERS, s->id);
+    rng_seed(&s->patience_rng, simulation_seed, replication, STREAM_PATIENCE, s->id);
+    rng_seed(&s->class_rng, simulation_seed, replication, STREAM_PRIORITY, s->id);
+    for (int i = 0; i < s->lane_count; i++) {
+        SimLane* lane = &s->lanes[i];
+        if (lane->kind == CASHIER) {
+            rng_seed(&lane->rng, simulation_seed, replication, STREAM_CASHIER, s->id * 65536 + i);
+        } else {
+            rng_seed(&lane->rng, simulation_seed, replication, STREAM_KIOSK, s->id * 65536 + (i - s->cashier_count));
+        }
+    }
+
+    s->cart_next = ARRIVAL_BATCH;
+    if (s->next_arrival != DBL_MAX && s->arrived >= s->initial_burst) {
+        s->arrival_clock = s->clock;
+        s->arrival_next = 0;
+        s->arrival_count = 0;
+        sim_schedule_next_arrival(s);
+    }
+}
+
+StoreSim** load_snapshot(const char* path, int* count, int replication) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        perror(path);
+        return NULL;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(SnapshotHeader)) {
+        printf("Snapshot %s is too short\n", path);
+        close(fd);
+        return NULL;
+    }
+    void* map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        perror("mmap");
+        return NULL;
+    }
+
+    const char* cursor = (const char*)map;
+    const char* end = cursor + st.st_size;
+    const SnapshotHeader* header = (const SnapshotHeader*)snapshot_take(&cursor, end, sizeof(SnapshotHeader));
+    if (memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic)) != 0) {
+        printf("%s is not a snapshot from this version\n", path);
+        munmap(map, st.st_size);
+        return NULL;
+    }
+    if (header->nhpp_arrivals != !uniform_arrivals()) {
+        printf("Snapshot was taken with %s arrivals; set CHECKOUT_ARRIVALS to match\n",
+               header->nhpp_arrivals ? "nhpp" : "uniform");
+        munmap(map, st.st_size);
+        return NULL;
+    }
+    simulation_seed = header->seed;
+
+    StoreSim** stores = (StoreSim**)malloc(sizeof(StoreSim*) * (header->store_count > 0 ? header->store_count : 1));
+    int restored = 0;
+    while (restored < header->store_count) {
+        StoreSim* s = restore_store(&cursor, end);
+        if (s == NULL) break;
+        if (replication != header->replication) branch_store(s, replication);
+        stores[restored++] = s;
+    }
+
+    if (restored < header->store_count) {
+        printf("Snapshot %s is truncated after %d of %d stores\n", path, restored, header->store_count);
+        for (int i = 0; i < restored; i++) store_sim_destroy(stores[i]);
+        free(stores);
+        munmap(map, st.st_size);
+        return NULL;
+    }
+    *count = restored;
+    munmap(map, st.st_size);
+    return stores;
+}
+
+void print_store_results(const char* label, StoreSim** stores, int count, double seconds) {
+    WaitHistogram* waits = (WaitHistogram*)malloc(sizeof(WaitHistogram));
+    histogram_reset(waits);
+    long long balked = 0;
+    long long reneged = 0;
+    WaitHistogram* class_totals = (WaitHistogram*)calloc(MAX_PRIORITY_CLASSES, sizeof(WaitHistogram));
+    for (int i = 0; i < count; i++) {
+        histogram_merge(waits, &stores[i]->waits);
+        for (int k = 0; stores[i]->class_waits != NULL && k < priority_class_count; k++) {
+            histogram_merge(&class_totals[k], &stores[i]->class_waits[k]);
+        }
+        balked += stores[i]->balked;
+        reneged += stores[i]->reneged;
+    }
+    printf("%s: %lld customers in %.3f s, wait mean %.2f s, p95 %.2f s, max %.2f s\n",
+           label, waits->count, seconds, histogram_mean_ms(waits) / 1000.0f,
+           histogram_percentile_ms(waits, 95.0f) / 1000.0f, waits->max_ms / 1000.0f);
+    if (lane_capacity > 0 || patience_mean > 0) {
+        char summary[128];
+        format_abandonment(summary, sizeof(summary), waits->count + balked + reneged, balked, reneged);
+        printf("  %s\n", summary);
+    }
+    if (priority_class_count > 1) print_class_waits("  ", class_totals);
+    free(class_totals);
+    free(waits);
+}
+
+int run_snapshot(int stores) {
+    StoreSim** all = (StoreSim**)malloc(sizeof(StoreSim*) * stores);
+    double start = wall_seconds();
+    for (int i = 0; i < stores; i++) {
+        all[i] = store_sim_create(i, i / stores_per_region, option_cashiers, option_kiosks, option_customers);
+        store_sim_advance(all[i], snapshot_at);
+    }
+    double simulated = wall_seconds() - start;
+
+    start = wall_seconds();
+    bool ok = save_snapshot(snapshot_path, all, stores, snapshot_at);
+    double saved = wall_seconds() - start;
+
+    if (ok) {
+        struct stat st;
+        long long size = stat(snapshot_path, &st) == 0 ? (long long)st.st_size : 0;
+        print_store_results("Warm-up", all, stores, simulated);
+        printf("Saved %d stores at t=%.0f s to %s (%lld bytes) in %.2f ms\n",
+               stores, snapshot_at, snapshot_path, size, saved * 1000.0);
+    }
+    for (int i = 0; i < stores; i++) store_sim_destroy(all[i]);
+    free(all);
+    return ok ? 0 : -1;
+}
+
+int run_restore() {
+    for (int b = 0; b < snapshot_branches; b++) {
+        int count = 0;
+        int replication = replication_id + b;
+        double start = wall_seconds();
+        StoreSim** stores = load_snapshot(restore_path, &count, replication);
+        double restored = wall_seconds() - start;
+        if (stores == NULL) return -1;
+
+        start = wall_seconds();
+        for (int i = 0; i < count; i++) store_sim_run(stores[i]);
+        double ran = wall_seconds() - start;
+
+        char label[64];
+        snprintf(label, sizeof(label), "Branch %d (replication %d, restored in %.2f ms)",
+                 b, replication, restored * 1000.0);
+        print_store_results(label, stores, count, ran);
+        for (int i = 0; i < count; i++) store_sim_destroy(stores[i]);
+        free(stores);
+    }
+    return 0;
+}
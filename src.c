@@ -1,3 +1,4 @@
+#define _GNU_SOURCE
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_ttf.h>
 #include <SDL2/SDL_image.h>
@@ -16,232 +17,277 @@
 Queue* create_queue();
 void enqueue(Queue* q, Customer* c);
 Customer* dequeue(Queue* q);
-float calculate_cashier_score(Cashier* cashier, Customer* customer);
-float calculate_kiosk_score(SelfCheckout* kiosk, Customer* customer);
-CheckoutOption get_best_checkout_option(Customer* customer);
-void* cashier_function(void* arg);
-void* selfcheckout_function(void* arg);
+void init_lanes();
+void start_lanes();
+void stop_lanes();
 SDL_Texture* renderText(SDL_Renderer *renderer, TTF_Font *font, const char *text, SDL_Color color);
 int getEmulationSpecs(SDL_Renderer *renderer, TTF_Font *font, const char *prompt, int minValue);
-Customer* create_customer(int id);
+Customer* create_customer(int id, int items);
+int load_options(int argc, char* argv[]);
+void init_rng_streams();
+void rng_seed(RngStream* r, uint64_t seed, int replication, RngStreamKind kind, int index);
+float rng_float(RngStream* r);
+void rng_fill_range(RngStream* r, int* out, int n, int min, int max);
+void rng_fill_gaps_ms(RngStream* r, Uint32* out, int n, Uint32 min_ms, Uint32 max_ms);
 bool init_visualization();
 void cleanup();
-void draw_tables_and_lanes(SDL_Renderer* renderer, Cashier** cashiers, int cashier_count);
-void update_customers();
+void draw_tables_and_lanes(SDL_Renderer* renderer, Lane* lanes, int cashier_count);
+bool update_customers();
+void route_customer(Customer* c);
+int next_cart_size();
+bool next_arrival_gap(Uint32* gap);
+void print_customer_pool_summary();
+void export_final_report();
+void print_wait_summary();
+void maybe_rebalance_queues();
+void print_jockey_summary();
+void init_autoscaler();
+void autoscale_lanes();
+void print_autoscale_summary();
+void init_service_estimate(ServiceEstimate* e, float prior);
+float initial_cashier_speed(int index, RngStream* r);
+void print_learning_summary();
+void init_routing();
+void print_routing_summary();
+double run_multi_store(int stores, int threads, bool verbose, WaitHistogram* waits_out);
+void run_scaling_test(int stores);
+int run_distributed(int workers);
+void init_arrival_model();
+bool uniform_arrivals();
+void fill_cart_sizes(RngStream* r, int* out, int n);
+int generate_arrival_times(RateCurve* curve, RngStream* r, double* clock, double horizon, double* out, int max);
+void benchmark_arrivals(int stores);
+int cashier_item_limit(int index);
+void init_lane_classes();
+void run_express_comparison(int stores);
+int run_snapshot(int stores);
+int run_restore();
+void init_telemetry();
+void publish_telemetry(int arrived);
+void shutdown_telemetry(int arrived);
+void init_charts();
+void sample_charts();
+void draw_charts();
+void free_charts();
+void free_final_report();
+void layout_store();
+void camera_fit();
+void init_redraw_events();
+Uint32 idle_wait_ms(Uint32 now, Uint32 next_arrival_time);
+bool camera_handle_event(SDL_Event* event);
 void render();
+void expire_patience(Uint32 now);
+void print_abandonment_summary(int arrived);
+void init_priority_classes();
+void print_priority_summary();
+int run_estimate(int stores);
+int run_staffing_search(int stores);
+void init_shared_queue_mode();
+void init_shared_lines();
+void free_shared_lines();
+void print_shared_line_summary();
+void run_shared_queue_comparison(int stores);
+void init_clock();
+Uint32 sim_ticks();
+Uint32 real_ticks();
+Uint32 clock_real_ms(Uint32 sim_ms);
+bool clock_handle_event(SDL_Event* event);
+void clock_wake_all();
 
 
 int main(int argc, char *argv[]) {
+    int options = load_options(argc, argv);
+    if (options <= 0) return options < 0 ? 1 : 0;
+    init_arrival_model();
+    init_priority_classes();
+    init_shared_queue_mode();
+    
+    if (arrival_bench_stores > 0) {
+        benchmark_arrivals(arrival_bench_stores);
+        return 0;
+    }
+    
+    if (restore_path != NULL) {
+        return run_restore() == 0 ? 0 : 1;
+    }
+    
+    if ((headless_mode || estimate_only || estimate_validate || optimize_staffing || shared_queue_compare) && store_count <= 0) store_count = 1;
+    
+    if (store_count > 0) {
+        if (option_cashiers <= 0) option_cashiers = 4;
+        if (option_kiosks < 0) option_kiosks = 2;
+        if (option_customers <= 0) option_customers = uniform_arrivals() ? 200 : INT_MAX;
+        if (estimate_only || estimate_validate) {
+            return run_estimate(store_count) == 0 ? 0 : 1;
+        } else if (optimize_staffing) {
+            return run_staffing_search(store_count) == 0 ? 0 : 1;
+        } else if (snapshot_path != NULL) {
+            return run_snapshot(store_count) == 0 ? 0 : 1;
+        } else if (worker_processes > 0) {
+            return run_distributed(worker_processes) == 0 ? 0 : 1;
+        } else if (scaling_test) {
+            run_scaling_test(store_count);
+        } else if (express_compare) {
+            run_express_comparison(store_count);
+        } else if (shared_queue_compare) {
+            run_shared_queue_comparison(store_count);
+        } else {
+            run_multi_store(store_count, shard_threads, true, NULL);
+        }
+        return 0;
+    }
+    
     if (!init_visualization()) {
         printf("Failed to initialize visualization!\n");
         return -1;
     }
     
-    cashier_count = getEmulationSpecs(renderer, font, "Enter the number of cashiers:", 1);
+    cashier_count = option_cashiers > 0 ? option_cashiers
+                                        : getEmulationSpecs(renderer, font, "Enter the number of cashiers:", 1);
     if (cashier_count <= 0) {
         cleanup();
         return 0;
     }
     
-    total_customers = getEmulationSpecs(renderer, font, "Enter the number of customers:", 1);
+    total_customers = option_customers > 0 ? option_customers
+                                           : getEmulationSpecs(renderer, font, "Enter the number of customers:", 1);
     if (total_customers <= 0) {
         cleanup();
         return 0;
     }
     
-    selfcheckout_count = getEmulationSpecs(renderer, font, "Enter the number of self-checkout kiosks:", 0);
+    selfcheckout_count = option_kiosks >= 0 ? option_kiosks
+                                            : getEmulationSpecs(renderer, font, "Enter the number of self-checkout kiosks:", 0);
     if (selfcheckout_count < 0) { 
         cleanup();
         return 0;
     }
     
-    srand(time(NULL));
+    init_rng_streams();
+    init_routing();
+    printf("Simulation seed: %llu (replication %d)\n", (unsigned long long)simulation_seed, replication_id);
     
-    all_customers = (Customer**)malloc(sizeof(Customer*) * total_customers);
-    for (int i = 0; i < total_customers; i++) {
-        all_customers[i] = create_customer(i + 1);
-    }
+    int initial_burst = uniform_arrivals() ? (cashier_count + selfcheckout_count) * 3 : 0;
     
-    float cashier_area_width = (selfcheckout_count > 0) ? SCREEN_WIDTH * 3/4 : SCREEN_WIDTH;
-    
-    all_cashiers = (Cashier**)malloc(sizeof(Cashier*) * cashier_count);
-    for (int i = 0; i < cashier_count; i++) {
-        all_cashiers[i] = (Cashier*)malloc(sizeof(Cashier));
-        all_cashiers[i]->id = i + 1;
-        all_cashiers[i]->queue = create_queue();
-        all_cashiers[i]->is_serving = false;
-        all_cashiers[i]->current_customer = NULL;
-        all_cashiers[i]->total_items_processed = 0;
-        all_cashiers[i]->total_customers_served = 0;
-        
-        all_cashiers[i]->avg_service_time_per_item = 0.5f + ((float)rand() / RAND_MAX);
-        
-        all_cashiers[i]->x = ((i + 1) * cashier_area_width) / (cashier_count + 1);
-        all_cashiers[i]->y = SCREEN_HEIGHT / 3;
-    }
+    layout_store();
     
-    if (selfcheckout_count > 0) {
-        all_kiosks = (SelfCheckout**)malloc(sizeof(SelfCheckout*) * selfcheckout_count);
-        for (int i = 0; i < selfcheckout_count; i++) {
-            all_kiosks[i] = (SelfCheckout*)malloc(sizeof(SelfCheckout));
-            all_kiosks[i]->id = i + 1;
-            all_kiosks[i]->queue = create_queue();
-            all_kiosks[i]->is_serving = false;
-            all_kiosks[i]->current_customer = NULL;
-            all_kiosks[i]->total_items_processed = 0;
-            all_kiosks[i]->total_customers_served = 0;
-            
-            all_kiosks[i]->avg_service_time_per_item = 0.8f;
-            
-            all_kiosks[i]->x = SCREEN_WIDTH * 7/8; 
-            int available_height = SCREEN_HEIGHT - 150;
-            int row_height = available_height / selfcheckout_count;
-            all_kiosks[i]->y = 120 + (row_height * i) + (row_height / 2);
-        }
-    }
+    init_lanes();
     
-    simulation_running = true;
-    simulation_start_time = SDL_GetTicks();
+    init_lane_classes();
+    init_shared_lines();
+    camera_fit();
+    init_redraw_events();
     
-    for (int i = 0; i < cashier_count; i++) {
-        pthread_create(&all_cashiers[i]->thread, NULL, cashier_function, all_cashiers[i]);
-    }
+    init_clock();
+    simulation_running = true;
+    simulation_start_time = sim_ticks();
+    init_autoscaler();
+    init_telemetry();
+    init_charts();
     
-    for (int i = 0; i < selfcheckout_count; i++) {
-        pthread_create(&all_kiosks[i]->thread, NULL, selfcheckout_function, all_kiosks[i]);
-    }
+    start_lanes();
     
     int current_customer = 0;
+    Uint32 arrival_gap = 0;
+    bool last_arrival_pending = next_arrival_gap(&arrival_gap);
     
-    for (int i = 0; i < total_customers && i < (cashier_count + selfcheckout_count) * 3; i++) {  
-        Customer* c = all_customers[current_customer++];
-        
-        CheckoutOption best_option = get_best_checkout_option(c);
-        
-        if (best_option.type == CASHIER) {
-            Cashier* cashier = all_cashiers[best_option.index];
-            
-            int queuePosition = 0;
-            for (int j = 0; j < total_customers; j++) {
-                if (all_customers[j]->is_active && 
-                    all_customers[j]->visual_state == QUEUED && 
-                    all_customers[j]->cashier_id == cashier->id) {
-                    queuePosition++;
-                }
-            }
-            
-            c->target_x = cashier->x;
-            c->target_y = cashier->y + TABLE_HEIGHT/2 + 20 + (queuePosition * CUSTOMER_SIZE);
-            c->cashier_id = cashier->id;
-            c->kiosk_id = -1;
-            
-            enqueue(cashier->queue, c);
-        } else if (best_option.type == KIOSK) {
-            SelfCheckout* kiosk = all_kiosks[best_option.index];
-            
-            int queuePosition = 0;
-            for (int j = 0; j < total_customers; j++) {
-                if (all_customers[j]->is_active && 
-                    all_customers[j]->visual_state == QUEUED && 
-                    all_customers[j]->kiosk_id == kiosk->id) {
-                    queuePosition++;
-                }
-            }
-            
-            int row_center_y = kiosk->y;
-            c->target_x = SCREEN_WIDTH * 3/4 + 20 + (queuePosition * CUSTOMER_SIZE);
-            c->target_y = row_center_y;
-            c->cashier_id = -1;
-            c->kiosk_id = kiosk->id;
-            
-            enqueue(kiosk->queue, c);
-        }
+    while (last_arrival_pending && current_customer < initial_burst) {
+        current_customer++;
+        route_customer(create_customer(current_customer, next_cart_size()));
+        last_arrival_pending = next_arrival_gap(&arrival_gap);
     }
     
     bool running = true;
-    Uint32 next_customer_time = SDL_GetTicks() + (rand() % 2000) + 1000;  
+    bool animating = true;
+    Uint32 drawn_second = 0;
+    Uint32 next_frame_time = real_ticks();
+    Uint32 next_customer_time = sim_ticks() + (last_arrival_pending ? arrival_gap : 0);  
     
     while (running) {
+        Uint32 frame_now = real_ticks();
+        Uint32 wait = next_frame_time > frame_now ? next_frame_time - frame_now : 0;
+        if (!animating && !view_dirty) {
+            wait = clock_real_ms(idle_wait_ms(sim_ticks(), last_arrival_pending ? next_customer_time : 0));
+        }
+        
         SDL_Event event;
-        while (SDL_PollEvent(&event)) {
+        bool have_event = SDL_WaitEventTimeout(&event, wait);
+        for (; have_event; have_event = SDL_PollEvent(&event)) {
             if (event.type == SDL_QUIT) {
                 running = false;
+            } else if (event.type == redraw_event) {
+                redraw_pending = 0;
+                view_dirty = true;
+            } else if (event.type == SDL_WINDOWEVENT) {
+                view_dirty = true;
+            } else if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_c) {
+                charts_visible = !charts_visible;
+                view_dirty = true;
+            } else if (clock_handle_event(&event)) {
+                view_dirty = true;
+            } else if (camera_handle_event(&event)) {
+                view_dirty = true;
             }
         }
         
-        if (current_customer < total_customers && SDL_GetTicks() > next_customer_time) {
-            Customer* c = all_customers[current_customer++];
-            
-            CheckoutOption best_option = get_best_checkout_option(c);
+        Uint32 now = sim_ticks();
+        if (sim_duration > 0 && now - simulation_start_time >= (Uint32)(sim_duration * 1000.0f)) {
+            running = false;
+        }
+        
+        while (last_arrival_pending && now > next_customer_time) {
+            current_customer++;
+            route_customer(create_customer(current_customer, next_cart_size()));
+            view_dirty = true;
             
-            if (best_option.type == CASHIER) {
-                Cashier* cashier = all_cashiers[best_option.index];
-                
-                int queuePosition = 0;
-                for (int j = 0; j < total_customers; j++) {
-                    if (all_customers[j]->is_active && 
-                        all_customers[j]->visual_state == QUEUED && 
-                        all_customers[j]->cashier_id == cashier->id) {
-                        queuePosition++;
-                    }
-                }
-                
-                c->target_x = cashier->x;
-                c->target_y = cashier->y + TABLE_HEIGHT/2 + 20 + (queuePosition * CUSTOMER_SIZE);
-                c->cashier_id = cashier->id;
-                c->kiosk_id = -1;
-                
-                enqueue(cashier->queue, c);
-            } else if (best_option.type == KIOSK) {
-                SelfCheckout* kiosk = all_kiosks[best_option.index];
-                
-                int queuePosition = 0;
-                for (int j = 0; j < total_customers; j++) {
-                    if (all_customers[j]->is_active && 
-                        all_customers[j]->visual_state == QUEUED && 
-                        all_customers[j]->kiosk_id == kiosk->id) {
-                        queuePosition++;
-                    }
-                }
-                
-                int row_center_y = kiosk->y;
-                c->target_x = SCREEN_WIDTH * 3/4 + 20 + (queuePosition * CUSTOMER_SIZE);
-                c->target_y = row_center_y;
-                c->cashier_id = -1;
-                c->kiosk_id = kiosk->id;
-                
-                enqueue(kiosk->queue, c);
+            last_arrival_pending = next_arrival_gap(&arrival_gap);
+            if (last_arrival_pending) {
+                next_customer_time += arrival_gap;
             }
-            
-            next_customer_time = SDL_GetTicks() + (rand() % 2000) + 1000;
         }
+        expire_patience(now);
+        
+        autoscale_lanes();
+        maybe_rebalance_queues();
+        publish_telemetry(current_customer);
+        sample_charts();
         
-        update_customers();
+        frame_now = real_ticks();
+        if (frame_now < next_frame_time) continue;
+        next_frame_time = frame_now + FRAME_MS;
         
-        render();
+        animating = update_customers();
         
-        SDL_Delay(30);  
+        Uint32 second = (now - simulation_start_time) / 1000;
+        if (second != drawn_second && !all_customers_served) view_dirty = true;
+        
+        if (animating || view_dirty) {
+            view_dirty = false;
+            drawn_second = second;
+            render();
+        }
     }
     
+    if (!all_customers_served) simulation_end_time = sim_ticks();
     simulation_running = false;
     all_customers_served = 1;
+    clock_wake_all();
     
-    for (int i = 0; i < cashier_count; i++) {
-        pthread_cond_broadcast(&all_cashiers[i]->queue->cond);
-    }
-    
-    for (int i = 0; i < selfcheckout_count; i++) {
-        pthread_cond_broadcast(&all_kiosks[i]->queue->cond);
-    }
-    
-    for (int i = 0; i < cashier_count; i++) {
-        pthread_join(all_cashiers[i]->thread, NULL);
-    }
-    
-    for (int i = 0; i < selfcheckout_count; i++) {
-        pthread_join(all_kiosks[i]->thread, NULL);
-    }
+    stop_lanes();
+    export_final_report();
     
+    shutdown_telemetry(current_customer);
+    print_routing_summary();
+    print_wait_summary();
+    print_jockey_summary();
+    print_autoscale_summary();
+    print_abandonment_summary(current_customer);
+    print_priority_summary();
+    print_shared_line_summary();
+    print_learning_summary();
+    print_customer_pool_summary();
+    free_charts();
+    free_shared_lines();
     cleanup();
     
     return 0;
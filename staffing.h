@@ -0,0 +1,199 @@
+#include "structs.h"
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define MIN_REPLICATIONS 3
+
+const double t_quantiles_95[30] = {
+    12.71, 4.30, 3.18, 2.78, 2.57, 2.45, 2.36, 2.31, 2.26, 2.23,
+    2.20, 2.18, 2.16, 2.14, 2.13, 2.12, 2.11, 2.10, 2.09, 2.09,
+    2.08, 2.07, 2.07, 2.06, 2.06, 2.06, 2.05, 2.05, 2.05, 2.04
+};
+
+StaffingResult* staffing_results;
+int staffing_evaluations = 0;
+int staffing_replications = 0;
+
+double t_quantile_95(int degrees) {
+    if (degrees < 1) return INFINITY;
+    return degrees <= 30 ? t_quantiles_95[degrees - 1] : 1.96;
+}
+
+StaffingResult* staffing_result(int cashiers, int kiosks) {
+    return &staffing_results[kiosks * (max_search_cashiers + 1) + cashiers];
+}
+
+double staffing_cost(int cashiers, int kiosks) {
+    return cashiers * cashier_cost + kiosks * kiosk_cost;
+}
+
+// Each replication continues its own copy of the warmed-up stores under fresh
+// streams; only waits after the warm-up count.
+void* staffing_replication_function(void* arg) {
+    ReplicationTask* task = (ReplicationTask*)arg;
+    WaitHistogram* waits = (WaitHistogram*)malloc(sizeof(WaitHistogram));
+    histogram_reset(waits);
+
+    for (int i = 0; i < task->store_count; i++) {
+        StoreSim* s = store_sim_clone(task->warm[i]);
+        branch_store(s, task->replication);
+        histogram_reset(&s->waits);
+        if (sim_duration > 0) {
+            store_sim_advance(s, sim_duration);
+        } else {
+            store_sim_run(s);
+        }
+        histogram_merge(waits, &s->waits);
+        store_sim_destroy(s);
+    }
+
+    task->p95 = histogram_percentile_ms(waits, 95.0f) / 1000.0;
+    task->mean = histogram_mean_ms(waits) / 1000.0;
+    free(waits);
+    return NULL;
+}
+
+// Replications run a batch per thread count at a time and stop once the 95%
+// confidence interval of the p95 wait is narrow enough or already lies on one
+// side of the SLO.
+StaffingResult* evaluate_staffing(int cashiers, int kiosks, int stores, int threads) {
+    StaffingResult* result = staffing_result(cashiers, kiosks);
+    if (result->evaluated) return result;
+
+    StoreSim** warm = (StoreSim**)malloc(sizeof(StoreSim*) * stores);
+    for (int i = 0; i < stores; i++) {
+        warm[i] = store_sim_create(i, i / stores_per_region, cashiers, kiosks, option_customers);
+        if (warmup_seconds > 0) store_sim_advance(warm[i], warmup_seconds);
+    }
+
+    ReplicationTask* tasks = (ReplicationTask*)calloc(max_replications, sizeof(ReplicationTask));
+    pthread_t* workers = (pthread_t*)malloc(sizeof(pthread_t) * threads);
+    double sum = 0.0, squares = 0.0, mean_wait = 0.0;
+    int done = 0;
+    while (done < max_replications) {
+        int batch = threads;
+        if (done < MIN_REPLICATIONS && batch < MIN_REPLICATIONS - done) batch = MIN_REPLICATIONS - done;
+        if (batch > max_replications - done) batch = max_replications - done;
+
+        for (int b = 0; b < batch; b += threads) {
+            int running = batch - b < threads ? batch - b : threads;
+            for (int t = 0; t < running; t++) {
+                ReplicationTask* task = &tasks[done + b + t];
+                task->warm = warm;
+                task->store_count = stores;
+                task->replication = replication_id + done + b + t;
+                pthread_create(&workers[t], NULL, staffing_replication_function, task);
+            }
+            for (int t = 0; t < running; t++) pthread_join(workers[t], NULL);
+        }
+        for (int r = done; r < done + batch; r++) {
+            sum += tasks[r].p95;
+            squares += tasks[r].p95 * tasks[r].p95;
+            mean_wait += tasks[r].mean;
+        }
+        done += batch;
+
+        double mean = sum / done;
+        double variance = done > 1 ? (squares - sum * mean) / (done - 1) : 0.0;
+        double half = t_quantile_95(done - 1) * sqrt(variance > 0 ? variance : 0.0) / sqrt((double)done);
+        result->p95_mean = mean;
+        result->p95_half_width = half;
+        if (half <= ci_precision * mean || mean - half > slo_p95_seconds || mean + half < slo_p95_seconds) break;
+    }
+
+    result->evaluated = true;
+    result->replications = done;
+    result->mean_wait = mean_wait / done;
+    result->feasible = result->p95_mean <= slo_p95_seconds;
+    staffing_evaluations++;
+    staffing_replications += done;
+
+    printf("%8d  %6d  %6.2f  %8.1f s +/- %5.1f  %8.1f s  %4d  %s\n", cashiers, kiosks,
+           staffing_cost(cashiers, kiosks), result->p95_mean, result->p95_half_width,
+           result->mean_wait, done, result->feasible ? "meets SLO" : "");
+
+    for (int i = 0; i < stores; i++) store_sim_destroy(warm[i]);
+    free(warm);
+    free(tasks);
+    free(workers);
+    return result;
+}
+
+// Waits only shrink as lanes are added, so for each kiosk count the fewest
+// cashiers that meet the SLO are found by bisection below the previous kiosk
+// count's answer. Kiosk counts stop once kiosks alone cost as much as the
+// cheapest mix found so far.
+int run_staffing_search(int stores) {
+    int cpus = online_cpu_count();
+    int threads = shard_threads > 0 ? shard_threads : cpus;
+    staffing_results = (StaffingResult*)calloc((max_search_cashiers + 1) * (max_search_kiosks + 1), sizeof(StaffingResult));
+
+    printf("Searching for the cheapest mix with p95 wait <= %.1f s (cashier %.2f, kiosk %.2f per lane), "
+           "%d stores per replication, %.0f s warm-up\n",
+           slo_p95_seconds, cashier_cost, kiosk_cost, stores, warmup_seconds);
+    printf("cashiers  kiosks    cost  p95 wait (95%% CI)      mean wait  reps\n");
+
+    double start = wall_seconds();
+    double best_cost = INFINITY;
+    int best_cashiers = -1, best_kiosks = -1;
+    int upper = max_search_cashiers;
+    bool upper_known = false;
+    for (int kiosks = 0; kiosks <= max_search_kiosks; kiosks++) {
+        int lower = kiosks == 0 ? 1 : 0;
+        if (staffing_cost(lower, kiosks) >= best_cost) break;
+
+        if (!upper_known && !evaluate_staffing(upper, kiosks, stores, threads)->feasible) continue;
+        upper_known = true;
+        int lo = lower - 1;
+        int hi = upper;
+        while (hi - lo > 1) {
+            int mid = (lo + hi) / 2;
+            if (evaluate_staffing(mid, kiosks, stores, threads)->feasible) hi = mid;
+            else lo = mid;
+        }
+        upper = hi;
+        if (staffing_cost(hi, kiosks) < best_cost) {
+            best_cost = staffing_cost(hi, kiosks);
+            best_cashiers = hi;
+            best_kiosks = kiosks;
+        }
+    }
+    double elapsed = wall_seconds() - start;
+
+    printf("Pareto frontier of cost against p95 wait:\n");
+    int cells = (max_search_cashiers + 1) * (max_search_kiosks + 1);
+    double last_p95 = INFINITY;
+    while (true) {
+        int next = -1;
+        for (int i = 0; i < cells; i++) {
+            StaffingResult* r = &staffing_results[i];
+            if (!r->evaluated || r->p95_mean >= last_p95) continue;
+            int c = i % (max_search_cashiers + 1), k = i / (max_search_cashiers + 1);
+            if (next < 0) {
+                next = i;
+                continue;
+            }
+            int nc = next % (max_search_cashiers + 1), nk = next / (max_search_cashiers + 1);
+            double cost = staffing_cost(c, k), next_cost = staffing_cost(nc, nk);
+            if (cost < next_cost || (cost == next_cost && r->p95_mean < staffing_results[next].p95_mean)) next = i;
+        }
+        if (next < 0) break;
+        int c = next % (max_search_cashiers + 1), k = next / (max_search_cashiers + 1);
+        printf("  cost %6.2f: %d cashiers + %d kiosks, p95 %.1f s\n", staffing_cost(c, k), c, k, staffing_results[next].p95_mean);
+        last_p95 = staffing_results[next].p95_mean;
+    }
+
+    if (best_cashiers < 0) {
+        printf("No mix up to %d cashiers and %d kiosks meets the SLO\n", max_search_cashiers, max_search_kiosks);
+    } else {
+        StaffingResult* best = staffing_result(best_cashiers, best_kiosks);
+        printf("Cheapest mix meeting the SLO: %d cashiers + %d kiosks (cost %.2f), p95 %.1f s +/- %.1f\n",
+               best_cashiers, best_kiosks, best_cost, best->p95_mean, best->p95_half_width);
+    }
+    printf("Evaluated %d mixes with %d replications in %.2f s\n", staffing_evaluations, staffing_replications, elapsed);
+
+    free(staffing_results);
+    return best_cashiers < 0 ? -1 : 0;
+}
@@ -0,0 +1,86 @@
+#include "structs.h"
+#include <pthread.h>
+#include <string.h>
+
+WaitHistogram wait_histogram;
+pthread_mutex_t wait_histogram_lock = PTHREAD_MUTEX_INITIALIZER;
+
+void histogram_reset(WaitHistogram* h) {
+    memset(h, 0, sizeof(WaitHistogram));
+}
+
+void histogram_record(WaitHistogram* h, Uint32 wait_ms) {
+    int bucket = wait_ms / WAIT_HISTOGRAM_BUCKET_MS;
+    if (bucket > WAIT_HISTOGRAM_BUCKETS) bucket = WAIT_HISTOGRAM_BUCKETS;
+    h->counts[bucket]++;
+    h->count++;
+    h->total_ms += wait_ms;
+    if (wait_ms > h->max_ms) h->max_ms = wait_ms;
+}
+
+void histogram_merge(WaitHistogram* into, const WaitHistogram* from) {
+    for (int i = 0; i <= WAIT_HISTOGRAM_BUCKETS; i++) {
+        into->counts[i] += from->counts[i];
+    }
+    into->count += from->count;
+    into->total_ms += from->total_ms;
+    if (from->max_ms > into->max_ms) into->max_ms = from->max_ms;
+}
+
+float histogram_mean_ms(const WaitHistogram* h) {
+    return h->count > 0 ? (float)(h->total_ms / h->count) : 0.0f;
+}
+
+Uint32 histogram_percentile_ms(const WaitHistogram* h, float percentile) {
+    if (h->count == 0) return 0;
+    long long rank = (long long)(percentile / 100.0f * h->count + 0.5f);
+    if (rank < 1) rank = 1;
+    long long seen = 0;
+    for (int i = 0; i <= WAIT_HISTOGRAM_BUCKETS; i++) {
+        seen += h->counts[i];
+        if (seen >= rank) {
+            Uint32 upper = (Uint32)(i + 1) * WAIT_HISTOGRAM_BUCKET_MS;
+            return upper < h->max_ms ? upper : h->max_ms;
+        }
+    }
+    return h->max_ms;
+}
+
+float histogram_fraction_within(const WaitHistogram* h, Uint32 limit_ms) {
+    if (h->count == 0) return 1.0f;
+    int last_bucket = limit_ms / WAIT_HISTOGRAM_BUCKET_MS;
+    if (last_bucket > WAIT_HISTOGRAM_BUCKETS) last_bucket = WAIT_HISTOGRAM_BUCKETS;
+    long long within = 0;
+    for (int i = 0; i < last_bucket; i++) within += h->counts[i];
+    return (float)within / h->count;
+}
+
+void record_customer_wait(Customer* c) {
+    Uint32 wait_ms = c->service_start_time - c->arrival_time;
+    pthread_mutex_lock(&wait_histogram_lock);
+    histogram_record(&wait_histogram, wait_ms);
+    if (priority_class_count > 1) histogram_record(&class_waits[c->priority], wait_ms);
+    pthread_mutex_unlock(&wait_histogram_lock);
+}
+
+void format_wait_summary(char* buffer, size_t size) {
+    int stolen = 0;
+    for (int i = 0; i < total_lane_count(); i++) stolen += all_lanes[i].customers_stolen;
+
+    pthread_mutex_lock(&wait_histogram_lock);
+    int n = snprintf(buffer, size, "Wait: mean %.1f s | p95 %.1f s | max %.1f s | stealing %s (%d stolen)",
+                     histogram_mean_ms(&wait_histogram) / 1000.0f,
+                     histogram_percentile_ms(&wait_histogram, 95.0f) / 1000.0f,
+                     wait_histogram.max_ms / 1000.0f,
+                     work_stealing_enabled ? "on" : "off", stolen);
+    pthread_mutex_unlock(&wait_histogram_lock);
+    if ((lane_capacity > 0 || patience_mean > 0) && n > 0 && (size_t)n < size) {
+        snprintf(buffer + n, size - n, " | %d balked, %d reneged", customers_balked, customers_reneged);
+    }
+}
+
+void print_wait_summary() {
+    char summary[160];
+    format_wait_summary(summary, sizeof(summary));
+    printf("%s over %lld customers\n", summary, wait_histogram.count);
+}
@@ -0,0 +1,495 @@
+#include "structs.h"
+#include <float.h>
+#include <stdlib.h>
+#include <string.h>
+
+void sim_push_event(StoreSim* s, double time, int lane) {
+    int i = s->event_count++;
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (s->events[parent].time <= time) break;
+        s->events[i] = s->events[parent];
+        i = parent;
+    }
+    s->events[i].time = time;
+    s->events[i].lane = lane;
+}
+
+SimEvent sim_pop_event(StoreSim* s) {
+    SimEvent top = s->events[0];
+    SimEvent last = s->events[--s->event_count];
+    int i = 0;
+    while (true) {
+        int child = 2 * i + 1;
+        if (child >= s->event_count) break;
+        if (child + 1 < s->event_count && s->events[child + 1].time < s->events[child].time) child++;
+        if (last.time <= s->events[child].time) break;
+        s->events[i] = s->events[child];
+        i = child;
+    }
+    if (s->event_count > 0) s->events[i] = last;
+    return top;
+}
+
+void sim_lane_push(SimLane* lane, SimCustomer c) {
+    if (lane->count == lane->capacity) {
+        int new_capacity = lane->capacity * 2;
+        SimCustomer* ring = (SimCustomer*)malloc(sizeof(SimCustomer) * new_capacity);
+        for (int i = 0; i < lane->count; i++) {
+            ring[i] = lane->ring[(lane->head + i) % lane->capacity];
+        }
+        free(lane->ring);
+        lane->ring = ring;
+        lane->capacity = new_capacity;
+        lane->head = 0;
+    }
+    int k = lane->count;
+    while (k > 0) {
+        SimCustomer* prev = &lane->ring[(lane->head + k - 1) % lane->capacity];
+        if (prev->priority <= c.priority) break;
+        lane->ring[(lane->head + k) % lane->capacity] = *prev;
+        k--;
+    }
+    lane->ring[(lane->head + k) % lane->capacity] = c;
+    lane->count++;
+    lane->queued_items += c.items;
+    lane->class_items[c.priority] += c.items;
+}
+
+bool sim_lane_remove(SimLane* lane, int id, SimCustomer* removed) {
+    for (int k = 0; k < lane->count; k++) {
+        SimCustomer* c = &lane->ring[(lane->head + k) % lane->capacity];
+        if (c->id != id) continue;
+        *removed = *c;
+        lane->queued_items -= c->items;
+        lane->class_items[c->priority] -= c->items;
+        for (int j = k; j < lane->count - 1; j++) {
+            lane->ring[(lane->head + j) % lane->capacity] = lane->ring[(lane->head + j + 1) % lane->capacity];
+        }
+        lane->count--;
+        return true;
+    }
+    return false;
+}
+
+SimCustomer sim_lane_pop(SimLane* lane) {
+    SimCustomer c = lane->ring[lane->head];
+    lane->head = (lane->head + 1) % lane->capacity;
+    lane->count--;
+    lane->queued_items -= c.items;
+    lane->class_items[c.priority] -= c.items;
+    return c;
+}
+
+// The real lanes' routing inputs packed LANE_VECTOR_WIDTH to a vector, so sim_route
+// scores every lane with a few vector ops: queued items per class, speed,
+// the end of the current service (0 when idle) and, for lanes serving from a
+// shared line, an all-ones flag and a weight of 1 for their line. Built from
+// the lanes after create, clone and restore, then kept current wherever a
+// queue or a service changes.
+void sim_build_route(StoreSim* s) {
+    int n = (s->lane_count + LANE_VECTOR_WIDTH - 1) / LANE_VECTOR_WIDTH;
+    if (n == 0) n = 1;
+    s->route_vectors = n;
+    size_t size = sizeof(LaneClockVector) * n + sizeof(LaneVector) * n * (MAX_PRIORITY_CLASSES + MAX_SHARED_LINES + 2);
+    char* block = (char*)aligned_alloc(sizeof(LaneClockVector), size);
+    memset(block, 0, size);
+    s->route_busy_until = (LaneClockVector*)block;
+    s->route_items = (LaneVector*)(s->route_busy_until + n);
+    s->route_line_weight = s->route_items + n * MAX_PRIORITY_CLASSES;
+    s->route_speed = s->route_line_weight + n * MAX_SHARED_LINES;
+    s->route_shared = (LaneIndexVector*)(s->route_speed + n);
+
+    int row = n * LANE_VECTOR_WIDTH;
+    for (int i = 0; i < s->lane_count; i++) {
+        SimLane* lane = &s->lanes[i];
+        for (int k = 0; k < MAX_PRIORITY_CLASSES; k++) ((float*)s->route_items)[k * row + i] = lane->class_items[k];
+        ((float*)s->route_speed)[i] = lane->speed;
+        ((double*)s->route_busy_until)[i] = lane->busy ? lane->busy_until : 0.0;
+        if (lane->line >= s->lane_count) {
+            ((int*)s->route_shared)[i] = -1;
+            ((float*)s->route_line_weight)[(lane->line - s->lane_count) * row + i] = 1.0f;
+        }
+    }
+}
+
+// All the packed inputs live in one block, headed by the clock vectors.
+void sim_free_route(StoreSim* s) {
+    free(s->route_busy_until);
+}
+
+void sim_track_queued(StoreSim* s, int index, int priority, int items) {
+    if (index >= s->lane_count) return;
+    ((float*)s->route_items)[priority * s->route_vectors * LANE_VECTOR_WIDTH + index] += items;
+}
+
+void sim_track_busy(StoreSim* s, int index) {
+    SimLane* lane = &s->lanes[index];
+    ((double*)s->route_busy_until)[index] = lane->busy ? lane->busy_until : 0.0;
+}
+
+void sim_refill_arrivals(StoreSim* s) {
+    s->arrival_next = 0;
+    if (uniform_arrivals()) {
+        Uint32 gaps[ARRIVAL_BATCH];
+        rng_fill_gaps_ms(&s->arrival_rng, gaps, ARRIVAL_BATCH, arrival_gap_min_ms, arrival_gap_max_ms);
+        for (int i = 0; i < ARRIVAL_BATCH; i++) {
+            s->arrival_clock += gaps[i] / 1000.0;
+            s->arrival_buffer[i] = s->arrival_clock;
+        }
+        s->arrival_count = ARRIVAL_BATCH;
+    } else {
+        s->arrival_count = generate_arrival_times(&arrival_curve, &s->arrival_rng, &s->arrival_clock,
+                                                  s->arrival_horizon, s->arrival_buffer, ARRIVAL_BATCH);
+    }
+}
+
+void sim_schedule_next_arrival(StoreSim* s) {
+    if (s->arrived >= s->total_customers) {
+        s->next_arrival = DBL_MAX;
+        return;
+    }
+    if (s->arrived < s->initial_burst) {
+        s->next_arrival = 0.0;
+        return;
+    }
+    if (s->arrival_next >= s->arrival_count) {
+        sim_refill_arrivals(s);
+    }
+    s->next_arrival = s->arrival_next < s->arrival_count ? s->arrival_buffer[s->arrival_next++] : DBL_MAX;
+}
+
+int sim_next_cart_size(StoreSim* s) {
+    if (s->cart_next >= ARRIVAL_BATCH) {
+        fill_cart_sizes(&s->customer_rng, s->cart_buffer, ARRIVAL_BATCH);
+        s->cart_next = 0;
+    }
+    return s->cart_buffer[s->cart_next++];
+}
+
+// Shared lines are queue-only entries after the real lanes, so patience
+// timers and snapshots address them like any lane. Each member lane's line
+// points at the queue it serves from; without sharing that is its own.
+void sim_attach_shared_lines(StoreSim* s, const CheckoutType* kinds, const int* limits) {
+    int* line_of = (int*)malloc(sizeof(int) * (s->lane_count > 0 ? s->lane_count : 1));
+    s->line_count = assign_shared_lines(kinds, limits, s->lane_count, line_of);
+    if (s->line_count > 0) {
+        s->lanes = (SimLane*)realloc(s->lanes, sizeof(SimLane) * (s->lane_count + s->line_count));
+        memset(s->lanes + s->lane_count, 0, sizeof(SimLane) * s->line_count);
+        for (int l = 0; l < s->line_count; l++) {
+            SimLane* line = &s->lanes[s->lane_count + l];
+            line->kind = NONE;
+            line->capacity = SIM_INITIAL_LANE_CAPACITY;
+            line->ring = (SimCustomer*)malloc(sizeof(SimCustomer) * line->capacity);
+            line->line = s->lane_count + l;
+        }
+        for (int i = 0; i < s->lane_count; i++) {
+            if (line_of[i] < 0) continue;
+            SimLane* line = &s->lanes[s->lane_count + line_of[i]];
+            line->speed += s->lanes[i].speed;
+            line->max_items = limits[i];
+            line->members++;
+            s->lanes[i].line = s->lane_count + line_of[i];
+        }
+        for (int l = 0; l < s->line_count; l++) {
+            SimLane* line = &s->lanes[s->lane_count + l];
+            line->speed /= line->members;
+        }
+    }
+    free(line_of);
+}
+
+StoreSim* store_sim_create(int id, int region, int cashiers, int kiosks, int customers) {
+    StoreSim* s = (StoreSim*)calloc(1, sizeof(StoreSim));
+    s->id = id;
+    s->region = region;
+    s->cashier_count = cashiers;
+    s->kiosk_count = kiosks;
+    s->lane_count = cashiers + kiosks;
+    s->lanes = (SimLane*)calloc(s->lane_count, sizeof(SimLane));
+    s->events = (SimEvent*)malloc(sizeof(SimEvent) * (s->lane_count > 0 ? s->lane_count : 1));
+    s->total_customers = customers;
+    s->initial_burst = customers < s->lane_count * 3 ? customers : s->lane_count * 3;
+
+    rng_seed(&s->arrival_rng, simulation_seed, replication_id, STREAM_ARRIVALS, region);
+    rng_seed(&s->customer_rng, simulation_seed, replication_id, STREAM_CUSTOMERS, id);
+    rng_seed(&s->patience_rng, simulation_seed, replication_id, STREAM_PATIENCE, id);
+    rng_seed(&s->class_rng, simulation_seed, replication_id, STREAM_PRIORITY, id);
+
+    int* limits = (int*)malloc(sizeof(int) * (s->lane_count > 0 ? s->lane_count : 1));
+    CheckoutType* kinds = (CheckoutType*)malloc(sizeof(CheckoutType) * (s->lane_count > 0 ? s->lane_count : 1));
+    for (int i = 0; i < s->lane_count; i++) {
+        SimLane* lane = &s->lanes[i];
+        lane->kind = i < cashiers ? CASHIER : KIOSK;
+        lane->capacity = SIM_INITIAL_LANE_CAPACITY;
+        lane->ring = (SimCustomer*)malloc(sizeof(SimCustomer) * lane->capacity);
+        if (lane->kind == CASHIER) {
+            rng_seed(&lane->rng, simulation_seed, replication_id, STREAM_CASHIER, id * 65536 + i);
+            lane->speed = initial_cashier_speed(i, &lane->rng);
+        } else {
+            rng_seed(&lane->rng, simulation_seed, replication_id, STREAM_KIOSK, id * 65536 + (i - cashiers));
+            lane->speed = kiosk_speed;
+        }
+        lane->max_items = lane->kind == CASHIER ? cashier_item_limit(i) : kiosk_item_limit;
+        lane->line = i;
+        lane->members = 1;
+        limits[i] = lane->max_items;
+        kinds[i] = lane->kind;
+    }
+    build_eligibility(&s->eligibility, limits, s->lane_count);
+    sim_attach_shared_lines(s, kinds, limits);
+    sim_build_route(s);
+    free(limits);
+    free(kinds);
+
+    s->arrival_horizon = uniform_arrivals() ? DBL_MAX : arrival_horizon_hours * 3600.0;
+    s->cart_next = ARRIVAL_BATCH;
+    if (!uniform_arrivals()) s->initial_burst = 0;
+    sim_schedule_next_arrival(s);
+
+    histogram_reset(&s->waits);
+    if (priority_class_count > 1) {
+        s->class_waits = (WaitHistogram*)calloc(priority_class_count, sizeof(WaitHistogram));
+    }
+    return s;
+}
+
+void store_sim_destroy(StoreSim* s) {
+    for (int i = 0; i < s->lane_count + s->line_count; i++) {
+        free(s->lanes[i].ring);
+    }
+    free(s->lanes);
+    free(s->events);
+    free_eligibility(&s->eligibility);
+    sim_free_route(s);
+    timers_free(&s->timers);
+    free(s->class_waits);
+    free(s);
+}
+
+// A deep copy, so several replications can continue one warmed-up store.
+StoreSim* store_sim_clone(const StoreSim* s) {
+    StoreSim* c = (StoreSim*)malloc(sizeof(StoreSim));
+    memcpy(c, s, sizeof(StoreSim));
+    int lanes = s->lane_count > 0 ? s->lane_count : 1;
+    int queues = s->lane_count + s->line_count;
+
+    c->lanes = (SimLane*)malloc(sizeof(SimLane) * (queues > 0 ? queues : 1));
+    memcpy(c->lanes, s->lanes, sizeof(SimLane) * queues);
+    for (int i = 0; i < queues; i++) {
+        c->lanes[i].ring = (SimCustomer*)malloc(sizeof(SimCustomer) * s->lanes[i].capacity);
+        memcpy(c->lanes[i].ring, s->lanes[i].ring, sizeof(SimCustomer) * s->lanes[i].capacity);
+    }
+    c->events = (SimEvent*)malloc(sizeof(SimEvent) * lanes);
+    memcpy(c->events, s->events, sizeof(SimEvent) * s->event_count);
+
+    size_t bits = sizeof(uint64_t) * ELIGIBILITY_BUCKETS * s->eligibility.words;
+    c->eligibility.bits = (uint64_t*)malloc(bits);
+    memcpy(c->eligibility.bits, s->eligibility.bits, bits);
+    sim_build_route(c);
+
+    c->timers.items = NULL;
+    if (s->timers.capacity > 0) {
+        c->timers.items = (PatienceTimer*)malloc(sizeof(PatienceTimer) * s->timers.capacity);
+        memcpy(c->timers.items, s->timers.items, sizeof(PatienceTimer) * s->timers.count);
+    }
+    if (s->class_waits != NULL) {
+        c->class_waits = (WaitHistogram*)malloc(sizeof(WaitHistogram) * priority_class_count);
+        memcpy(c->class_waits, s->class_waits, sizeof(WaitHistogram) * priority_class_count);
+    }
+    return c;
+}
+
+// Only customers of the same or a higher class are ahead of a new arrival.
+float sim_lane_pending_seconds(StoreSim* s, SimLane* lane, int priority) {
+    int items = lane->queued_items;
+    if (priority < priority_class_count - 1) {
+        items = 0;
+        for (int k = 0; k <= priority; k++) items += lane->class_items[k];
+    }
+    float pending = lane->speed * items;
+    if (lane->busy && lane->busy_until > s->clock) {
+        pending += (float)(lane->busy_until - s->clock);
+    }
+    return pending;
+}
+
+// The work queued in a shared line plus what its members still have in
+// hand, spread over the members.
+float sim_line_pending_seconds(StoreSim* s, int index, int priority) {
+    SimLane* line = &s->lanes[index];
+    float pending = sim_lane_pending_seconds(s, line, priority);
+    for (int i = 0; i < s->lane_count; i++) {
+        SimLane* lane = &s->lanes[i];
+        if (lane->line == index && lane->busy && lane->busy_until > s->clock) {
+            pending += (float)(lane->busy_until - s->clock);
+        }
+    }
+    return pending / line->members;
+}
+
+// Scores every real lane from the packed inputs, the same sums a scalar scan
+// over the lanes would make, so the same lane wins. Lanes outside the cart's
+// eligibility bitset score infinity; ties go to the lowest lane.
+int sim_route(StoreSim* s, int items, int priority) {
+    const uint64_t* eligible = eligible_lanes(&s->eligibility, items);
+    float line_pending[MAX_SHARED_LINES];
+    for (int l = 0; l < s->line_count; l++) {
+        line_pending[l] = sim_line_pending_seconds(s, s->lane_count + l, priority);
+    }
+
+    int n = s->route_vectors;
+    LaneVector cart = (LaneVector){0} + (float)items;
+    LaneVector infinity = (LaneVector){0} + INFINITY;
+    LaneClockVector clock = (LaneClockVector){0} + s->clock;
+    LaneIndexVector index;
+    lane_vector_offsets(&index);
+    LaneVector best = infinity;
+    LaneIndexVector best_index = index;
+    for (int v = 0; v < n; v++) {
+        LaneVector ahead = s->route_items[v];
+        for (int k = 1; k <= priority; k++) ahead += s->route_items[k * n + v];
+        LaneVector remaining = __builtin_convertvector(s->route_busy_until[v] - clock, LaneVector);
+        LaneVector pending = s->route_speed[v] * ahead + (LaneVector)((LaneIndexVector)remaining & (remaining > 0.0f));
+
+        LaneVector line = (LaneVector){0};
+        for (int l = 0; l < s->line_count; l++) line += s->route_line_weight[l * n + v] * line_pending[l];
+        LaneIndexVector shared = s->route_shared[v];
+        pending = (LaneVector)(((LaneIndexVector)line & shared) | ((LaneIndexVector)pending & ~shared));
+
+        LaneVector score = pending + s->route_speed[v] * cart;
+        LaneIndexVector admitted;
+        admitted_lanes(eligible, v, &admitted);
+        score = (LaneVector)(((LaneIndexVector)score & admitted) | ((LaneIndexVector)infinity & ~admitted));
+
+        LaneIndexVector better = score < best;
+        best = (LaneVector)(((LaneIndexVector)score & better) | ((LaneIndexVector)best & ~better));
+        best_index = (index & better) | (best_index & ~better);
+        index += LANE_VECTOR_WIDTH;
+    }
+
+    float best_score = INFINITY;
+    int best_lane = 0;
+    for (int i = 0; i < LANE_VECTOR_WIDTH; i++) {
+        if (best[i] < best_score || (best[i] == best_score && best_index[i] < best_lane)) {
+            best_score = best[i];
+            best_lane = best_index[i];
+        }
+    }
+    return best_lane;
+}
+
+void sim_start_service(StoreSim* s, int index) {
+    SimLane* lane = &s->lanes[index];
+    lane->current = sim_lane_pop(&s->lanes[lane->line]);
+    lane->busy = true;
+    sim_track_queued(s, lane->line, lane->current.priority, -lane->current.items);
+
+    double duration = draw_service_ms(&lane->rng, lane->speed, lane->current.items) / 1000.0;
+    lane->busy_until = s->clock + duration;
+    lane->busy_seconds += duration;
+    sim_track_busy(s, index);
+    Uint32 wait_ms = (Uint32)((s->clock - lane->current.arrival) * 1000.0);
+    histogram_record(&s->waits, wait_ms);
+    if (s->class_waits != NULL) histogram_record(&s->class_waits[lane->current.priority], wait_ms);
+    sim_push_event(s, lane->busy_until, index);
+}
+
+// A line only holds customers while all its members are busy, so this is
+// needed only for the first customer in it.
+int sim_idle_member(StoreSim* s, int queue_index, int fallback) {
+    int best = fallback;
+    for (int i = 0; i < s->lane_count; i++) {
+        SimLane* lane = &s->lanes[i];
+        if (lane->line != queue_index || lane->busy) continue;
+        if (s->lanes[best].busy || lane->speed < s->lanes[best].speed) best = i;
+    }
+    return best;
+}
+
+void sim_handle_arrival(StoreSim* s) {
+    SimCustomer c;
+    c.id = ++s->arrived;
+    c.items = sim_next_cart_size(s);
+    c.priority = draw_priority_class(&s->class_rng);
+    c.arrival = s->clock;
+
+    int index = sim_route(s, c.items, c.priority);
+    int queue_index = s->lanes[index].line;
+    SimLane* queue = &s->lanes[queue_index];
+    if (lane_full(queue->count / queue->members)) {
+        s->balked++;
+    } else {
+        sim_lane_push(queue, c);
+        sim_track_queued(s, queue_index, c.priority, c.items);
+        if (queue_index != index && s->lanes[index].busy && queue->count == 1) {
+            index = sim_idle_member(s, queue_index, index);
+        }
+        if (!s->lanes[index].busy) {
+            sim_start_service(s, index);
+        } else if (patience_mean > 0) {
+            double deadline = s->clock + rng_exponential(&s->patience_rng, patience_mean);
+            timers_push(&s->timers, (PatienceTimer){.deadline = deadline, .lane = queue_index, .customer = c.id});
+        }
+    }
+
+    sim_schedule_next_arrival(s);
+}
+
+void sim_handle_renege(StoreSim* s) {
+    PatienceTimer t = timers_pop(&s->timers);
+    SimCustomer removed;
+    if (sim_lane_remove(&s->lanes[t.lane], t.customer, &removed)) {
+        sim_track_queued(s, t.lane, removed.priority, -removed.items);
+        s->reneged++;
+    }
+}
+
+void sim_handle_completion(StoreSim* s, int index) {
+    SimLane* lane = &s->lanes[index];
+    lane->total_customers_served++;
+    lane->total_items_processed += lane->current.items;
+    lane->busy = false;
+    sim_track_busy(s, index);
+    s->served++;
+
+    if (s->lanes[lane->line].count > 0) sim_start_service(s, index);
+}
+
+bool store_sim_done(StoreSim* s) {
+    return s->next_arrival == DBL_MAX && s->served + s->balked + s->reneged >= s->arrived;
+}
+
+void store_sim_advance(StoreSim* s, double until) {
+    while (true) {
+        double next_completion = s->event_count > 0 ? s->events[0].time : DBL_MAX;
+        double next_arrival = s->next_arrival;
+        double next = next_arrival <= next_completion ? next_arrival : next_completion;
+        double next_timer = timers_next(&s->timers);
+        if (next_timer < next) {
+            if (next_timer > until) break;
+            if (store_sim_done(s)) {
+                s->timers.count = 0;
+                continue;
+            }
+            s->clock = next_timer;
+            sim_handle_renege(s);
+            s->events_processed++;
+            continue;
+        }
+        if (next == DBL_MAX || next > until) break;
+
+        s->clock = next;
+        if (next_arrival <= next_completion) {
+            sim_handle_arrival(s);
+        } else {
+            sim_handle_completion(s, sim_pop_event(s).lane);
+        }
+        s->events_processed++;
+    }
+    if (until != DBL_MAX && until > s->clock) s->clock = until;
+}
+
+void store_sim_run(StoreSim* s) {
+    store_sim_advance(s, DBL_MAX);
+}
@@ -1,4 +1,10 @@
+#ifndef STRUCTS_H
+#define STRUCTS_H
+
 #include <pthread.h>
+#include <semaphore.h>
+#include <stddef.h>
+#include <stdint.h>
 
 typedef enum {
     WAITING_TO_ENTER,
@@ -15,52 +21,216 @@ typedef enum {
     KIOSK
 } CheckoutType;
 
+typedef enum {
+    LANE_OPEN,
+    LANE_DRAINING,
+    LANE_CLOSED
+} LaneStatus;
+
 typedef enum {
     INPUT_CASHIERS,
     INPUT_CUSTOMERS,
     SIMULATION_RUNNING
 } ProgramState;
 
+typedef enum {
+    SHARED_OFF,
+    SHARED_ALL,
+    SHARED_CASHIERS,
+    SHARED_KIOSKS,
+    SHARED_SPLIT
+} SharedQueueMode;
+
+typedef struct {
+    uint64_t state;
+    uint64_t inc;
+} RngStream;
+
+typedef enum {
+    STREAM_ARRIVALS,
+    STREAM_CUSTOMERS,
+    STREAM_CASHIER,
+    STREAM_KIOSK,
+    STREAM_ROUTING,
+    STREAM_PATIENCE,
+    STREAM_PRIORITY
+} RngStreamKind;
+
+#define ARRIVAL_BATCH 256
+#define MAX_CART_ITEMS 100
+#define RATE_CURVE_MAX_SEGMENTS 288
+#define ELIGIBILITY_BUCKETS 64
+#define SIM_INITIAL_LANE_CAPACITY 16
+#define SERIES_CAPACITY 240
+#define MAX_PRIORITY_CLASSES 4
+#define MAX_SHARED_LINES 4
+#define CACHE_LINE 64
+
+#define WAIT_HISTOGRAM_BUCKETS 6000
+#define WAIT_HISTOGRAM_BUCKET_MS 100
+
+typedef struct {
+    int counts[WAIT_HISTOGRAM_BUCKETS + 1];
+    long long count;
+    double total_ms;
+    Uint32 max_ms;
+} WaitHistogram;
+
+typedef struct {
+    float seconds_per_item;
+    float observed_items;
+    int observations;
+    int converged_after;
+} ServiceEstimate;
+
+typedef struct {
+    float values[SERIES_CAPACITY];
+    int head;
+    int count;
+} TimeSeries;
+
+typedef struct {
+    char text[64];
+    SDL_Texture* texture;
+    int width;
+    int height;
+} CachedLabel;
+
+typedef struct {
+    float x;
+    float y;
+    float zoom;
+    float min_zoom;
+    bool dragging;
+} Camera;
+
+typedef struct {
+    Uint32 duration_ms;
+    int customers_processed;
+    int items_processed;
+    int fastest_cashier_id;
+    int slowest_cashier_id;
+    float fastest_cashier_speed;
+    float slowest_cashier_speed;
+    float avg_time_per_item;
+    float wait_mean;
+    float wait_p50;
+    float wait_p95;
+    float wait_p99;
+    float wait_max;
+    int stolen;
+    int balked;
+    int reneged;
+    char wait_summary[160];
+} FinalReport;
+
 struct Node;
 struct Queue;
-struct Cashier;
-struct SelfCheckout;
+struct Lane;
 struct Customer;
 
 typedef struct {
-    CheckoutType type;
-    int index;
-} CheckoutOption;
+    const char* name;
+    struct Lane* (*choose)(struct Customer* customer);
+} RoutingPolicy;
 
+// Records live in CustomerPool and are recycled once the customer has left,
+// so memory follows the customers in the store rather than the whole run.
+// lane_id indexes all_lanes and line_id shared_lines, both 1-based with 0 for
+// none. claimed stays a whole byte because lanes and reneging race on it.
 typedef struct Customer {
-    int id;
-    int service_time;
-    int items;
-    CustomerVisualState visual_state;
+    uint32_t id;
+    uint32_t slot;
+    Uint32 arrival_time;        
+    Uint32 service_start_time;  
+    Uint32 service_duration_ms; 
     float x, y;                 
     float target_x, target_y;  
-    int cashier_id;             
-    int kiosk_id;               
-    Uint32 service_start_time;  
-    bool is_active;
-    bool has_reached_cashier;   
-    bool has_reached_kiosk;     
+    uint16_t items;
+    uint16_t lane_id;
+    uint8_t line_id;
+    uint8_t claimed;
+    unsigned visual_state : 3;
+    unsigned priority : 3;
+    unsigned is_active : 1;
+    unsigned reached_lane : 1;
+    unsigned ring_pinned : 1;
 } Customer;
 
+#define CUSTOMER_POOL_CHUNK 256
+
+// A reneged customer stays in its shared line's ring as a tombstone until a
+// lane pops past it and marks it released.
+#define CUSTOMER_RING_RELEASED 2
+
+typedef struct {
+    Customer** chunks;
+    int chunk_count;
+    uint32_t* free_slots;
+    int free_count;
+    Customer** in_store;
+    int in_store_count;
+    int peak_in_store;
+    long long recycled;
+} CustomerPool;
+
 typedef struct Node {
     Customer* data;
     struct Node* next;
+    struct Node* prev;
 } Node;
 
 typedef struct Queue {
     Node* front;
     Node* rear;
     int size;
+    int total_items;
+    Node* class_tail[MAX_PRIORITY_CLASSES];
+    int class_items[MAX_PRIORITY_CLASSES];
+    int lane;
     pthread_mutex_t lock;
     pthread_cond_t cond;
 } Queue;
 
-typedef struct Cashier {
+typedef struct {
+    size_t sequence;
+    Customer* data;
+} MpmcCell;
+
+// The two counters sit on separate cache lines so producers and consumers
+// do not false-share.
+typedef struct {
+    MpmcCell* cells;
+    size_t mask;
+    size_t enqueue_pos __attribute__((aligned(CACHE_LINE)));
+    size_t dequeue_pos __attribute__((aligned(CACHE_LINE)));
+} __attribute__((aligned(CACHE_LINE))) MpmcRing;
+
+typedef struct {
+    MpmcRing rings[MAX_PRIORITY_CLASSES];
+    sem_t ready;
+    int size;
+    int class_items[MAX_PRIORITY_CLASSES];
+    int served;
+    int members;
+    int open_members;
+    int max_items;
+    float x, y, width;
+} SharedLine;
+
+typedef struct {
+    SharedLine* line;
+    Queue* queue;
+    Customer* customers;
+    int count;
+    int* consumed;
+    int total;
+} DispatchWorker;
+
+// Cashiers and kiosks share one record; kind says which. Cashiers come
+// first in all_lanes, so a lane's index is its routing and eligibility slot.
+typedef struct Lane {
+    CheckoutType kind;
     int id;
     pthread_t thread;
     Queue* queue;
@@ -70,16 +240,274 @@ typedef struct Cashier {
     float avg_service_time_per_item; 
     int total_items_processed;  
     int total_customers_served; 
-} Cashier;
+    int customers_stolen;       
+    LaneStatus status;
+    ServiceEstimate estimate;
+    RngStream rng;
+    int max_items;
+    Uint64 busy_ms;
+    SharedLine* line;
+} Lane;
+
+// Lanes scored per vector op: eight with AVX, four on plain SSE2 where wider
+// vectors are split into slower pieces.
+#ifdef __AVX__
+#define LANE_VECTOR_WIDTH 8
+#else
+#define LANE_VECTOR_WIDTH 4
+#endif
+
+typedef float LaneVector __attribute__((vector_size(LANE_VECTOR_WIDTH * sizeof(float))));
+typedef int LaneIndexVector __attribute__((vector_size(LANE_VECTOR_WIDTH * sizeof(int))));
+typedef double LaneClockVector __attribute__((vector_size(LANE_VECTOR_WIDTH * sizeof(double))));
 
-typedef struct SelfCheckout {
+typedef struct {
+    int segments;
+    double segment_seconds;
+    double offset_seconds;
+    double rates[RATE_CURVE_MAX_SEGMENTS];
+} RateCurve;
+
+// Lanes sorted fastest first; head and tail hold one cart size's integrals.
+typedef struct {
+    double speed;
+    int max_items;
+    double rho;
+    double theta;
+    double work;
+    double head;
+    double tail;
+} EstimateLane;
+
+// Per cart size, the lanes that take it in speed order and the parts of its
+// integrals that do not depend on utilisation, rows of lanes entries each.
+typedef struct {
+    int lanes;
+    int used[MAX_CART_ITEMS];
+    int* index;
+    double* beta;
+    double* head;
+    double* tail;
+} CartChoices;
+
+// One stationary component per rate-curve segment (just one for uniform
+// arrivals), weighted by its share of the arrivals.
+typedef struct {
+    int servers;
+    double capacity;
+    double arrival_rate;
+    double utilization;
+    double peak_utilization;
+    double saturated_share;
+    int components;
+    double weight[RATE_CURVE_MAX_SEGMENTS];
+    double wait_probability[RATE_CURVE_MAX_SEGMENTS];
+    double conditional_wait[RATE_CURVE_MAX_SEGMENTS];
+} QueueEstimate;
+
+typedef struct {
+    int size;
+    float* prob;
+    int* alias;
+} AliasTable;
+
+// One bitset of lane indices per cart-size bucket; carts at or above the last
+// bucket share it.
+typedef struct {
+    int lanes;
+    int words;
+    uint64_t* bits;
+} EligibilityTable;
+
+typedef struct {
     int id;
-    pthread_t thread;
-    Queue* queue;
-    float x, y;              
-    bool is_serving;         
-    Customer* current_customer; 
-    float avg_service_time_per_item; 
-    int total_items_processed; 
-    int total_customers_served; 
-} SelfCheckout;
\ No newline at end of file
+    int items;
+    int priority;
+    double arrival;
+} SimCustomer;
+
+// Patience deadlines for every queued customer, kept in one min-heap per
+// store instead of being polled customer by customer. Entries for customers
+// who reached service first are dropped when they expire. The headless sim
+// keys a timer by queue and customer index, the window by the customer's
+// pool slot and the id that tells whether the slot was reused.
+typedef struct {
+    double deadline;
+    union {
+        struct {
+            int lane;
+            int customer;
+        };
+        struct {
+            uint32_t slot;
+            uint32_t id;
+        };
+    };
+} PatienceTimer;
+
+typedef struct {
+    PatienceTimer* items;
+    int count;
+    int capacity;
+} PatienceTimers;
+
+typedef struct {
+    CheckoutType kind;
+    float speed;
+    SimCustomer* ring;
+    int capacity;
+    int head;
+    int count;
+    int queued_items;
+    int class_items[MAX_PRIORITY_CLASSES];
+    bool busy;
+    double busy_until;
+    SimCustomer current;
+    int total_customers_served;
+    int total_items_processed;
+    double busy_seconds;
+    RngStream rng;
+    int max_items;
+    int line;
+    int members;
+} SimLane;
+
+typedef struct {
+    double time;
+    int lane;
+} SimEvent;
+
+typedef struct StoreSim {
+    int id;
+    int region;
+    int cashier_count;
+    int kiosk_count;
+    int lane_count;
+    int line_count;
+    SimLane* lanes;
+    SimEvent* events;
+    int event_count;
+    double clock;
+    double next_arrival;
+    int total_customers;
+    int initial_burst;
+    int arrived;
+    int served;
+    long long events_processed;
+    RngStream arrival_rng;
+    RngStream customer_rng;
+    double arrival_clock;
+    double arrival_horizon;
+    double arrival_buffer[ARRIVAL_BATCH];
+    int arrival_next;
+    int arrival_count;
+    int cart_buffer[ARRIVAL_BATCH];
+    int cart_next;
+    EligibilityTable eligibility;
+    RngStream patience_rng;
+    PatienceTimers timers;
+    int balked;
+    int reneged;
+    RngStream class_rng;
+    WaitHistogram* class_waits;
+    WaitHistogram waits;
+    // Packed copies of the lanes' routing inputs; see sim_route.
+    int route_vectors;
+    LaneVector* route_items;
+    LaneVector* route_speed;
+    LaneClockVector* route_busy_until;
+    LaneIndexVector* route_shared;
+    LaneVector* route_line_weight;
+} StoreSim;
+
+#define SNAPSHOT_MAGIC "CKSNAP04"
+
+typedef struct {
+    char magic[8];
+    int store_count;
+    int nhpp_arrivals;
+    uint64_t seed;
+    int replication;
+    double clock;
+} SnapshotHeader;
+
+typedef struct {
+    int id;
+    int region;
+    int cashier_count;
+    int kiosk_count;
+    int event_count;
+    int total_customers;
+    int initial_burst;
+    int arrived;
+    int served;
+    int arrivals_pending;
+    int carts_pending;
+    int histogram_buckets;
+    int timer_count;
+    int balked;
+    int reneged;
+    int priority_classes;
+    int line_count;
+    long long events_processed;
+    double clock;
+    double next_arrival;
+    double arrival_clock;
+    double arrival_horizon;
+    RngStream arrival_rng;
+    RngStream customer_rng;
+    RngStream patience_rng;
+    RngStream class_rng;
+    long long wait_count;
+    double wait_total_ms;
+    Uint32 wait_max_ms;
+} SnapshotStore;
+
+typedef struct {
+    int index;
+    int thread_count;
+    int cpu;
+    int store_count;
+    StoreSim** stores;
+    WaitHistogram waits;
+    WaitHistogram class_waits[MAX_PRIORITY_CLASSES];
+    long long customers;
+    long long balked;
+    long long reneged;
+    long long events;
+    double seconds;
+} StoreShard;
+
+typedef struct {
+    bool evaluated;
+    bool feasible;
+    int replications;
+    double p95_mean;
+    double p95_half_width;
+    double mean_wait;
+} StaffingResult;
+
+typedef struct {
+    StoreSim** warm;
+    int store_count;
+    int replication;
+    double p95;
+    double mean;
+} ReplicationTask;
+
+typedef struct {
+    double until;
+    int stop;
+} WindowCommand;
+
+typedef struct {
+    int worker;
+    int stores_done;
+    long long arrived;
+    long long served;
+    long long balked;
+    long long reneged;
+    long long events;
+} WindowReport;
+
+#endif
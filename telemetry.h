@@ -0,0 +1,117 @@
+#include "structs.h"
+#include "telemetry_shm.h"
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+TelemetrySegment* telemetry_segment = NULL;
+Uint32 next_telemetry_time = 0;
+
+void init_telemetry() {
+    if (!telemetry_enabled) return;
+
+    int fd = shm_open(telemetry_name, O_CREAT | O_RDWR, 0644);
+    if (fd < 0) {
+        perror("shm_open");
+        return;
+    }
+    if (ftruncate(fd, sizeof(TelemetrySegment)) != 0) {
+        perror("ftruncate");
+        close(fd);
+        return;
+    }
+    void* map = mmap(NULL, sizeof(TelemetrySegment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        perror("mmap");
+        return;
+    }
+
+    telemetry_segment = (TelemetrySegment*)map;
+    memset(telemetry_segment, 0, sizeof(TelemetrySegment));
+    telemetry_segment->version = TELEMETRY_VERSION;
+    telemetry_segment->data.pid = (int32_t)getpid();
+    telemetry_segment->data.seed = simulation_seed;
+    __atomic_store_n(&telemetry_segment->magic, TELEMETRY_MAGIC, __ATOMIC_RELEASE);
+    printf("Publishing telemetry to shared memory %s\n", telemetry_name);
+}
+
+void fill_telemetry_lane(TelemetryLane* out, int kind, int status, Queue* q, int line_share, bool serving,
+                         int served, int items, Uint64 busy_ms, float seconds_per_item, Uint32 elapsed_ms) {
+    pthread_mutex_lock(&q->lock);
+    out->queue_length = q->size + line_share;
+    pthread_mutex_unlock(&q->lock);
+    out->kind = kind;
+    out->status = status;
+    out->serving = serving;
+    out->served = served;
+    out->items = items;
+    out->utilization = elapsed_ms > 0 ? (float)busy_ms / elapsed_ms : 0.0f;
+    out->seconds_per_item = seconds_per_item;
+}
+
+// Everything is gathered into a local snapshot first so the segment is only
+// odd for the duration of one memcpy.
+void publish_telemetry(int arrived) {
+    if (telemetry_segment == NULL) return;
+
+    Uint32 now = sim_ticks();
+    if (now < next_telemetry_time) return;
+    next_telemetry_time = now + telemetry_interval_ms;
+
+    TelemetrySnapshot snapshot;
+    memset(&snapshot, 0, sizeof(snapshot));
+    Uint32 elapsed_ms = now - simulation_start_time;
+    snapshot.running = simulation_running;
+    snapshot.pid = telemetry_segment->data.pid;
+    snapshot.seed = simulation_seed;
+    snapshot.uptime_seconds = elapsed_ms / 1000.0;
+    snapshot.arrived = arrived;
+    snapshot.served = customers_served;
+    snapshot.total_customers = total_customers;
+
+    // A shared line's customers are split over its open members, so the lane
+    // queues still add up to everyone waiting.
+    int line_length[MAX_SHARED_LINES];
+    int line_rank[MAX_SHARED_LINES] = {0};
+    for (int l = 0; l < shared_line_count; l++) line_length[l] = shared_line_length(&shared_lines[l]);
+
+    int lanes = 0;
+    for (int i = 0; i < total_lane_count() && lanes < TELEMETRY_MAX_LANES; i++, lanes++) {
+        Lane* lane = &all_lanes[i];
+        int line_share = 0;
+        if (lane->line != NULL && lane->status == LANE_OPEN) {
+            int l = shared_line_index(lane->line);
+            int servers = shared_line_servers(lane->line);
+            line_share = line_length[l] / servers + (line_rank[l]++ < line_length[l] % servers ? 1 : 0);
+        }
+        fill_telemetry_lane(&snapshot.lanes[lanes], lane->kind == CASHIER ? TELEMETRY_LANE_CASHIER : TELEMETRY_LANE_KIOSK,
+                            lane->status, lane->queue, line_share, lane->is_serving,
+                            lane->total_customers_served, lane->total_items_processed, lane->busy_ms,
+                            lane->avg_service_time_per_item, elapsed_ms);
+    }
+    snapshot.lane_count = lanes;
+
+    pthread_mutex_lock(&wait_histogram_lock);
+    snapshot.wait_mean = histogram_mean_ms(&wait_histogram) / 1000.0f;
+    snapshot.wait_p50 = histogram_percentile_ms(&wait_histogram, 50.0f) / 1000.0f;
+    snapshot.wait_p95 = histogram_percentile_ms(&wait_histogram, 95.0f) / 1000.0f;
+    snapshot.wait_p99 = histogram_percentile_ms(&wait_histogram, 99.0f) / 1000.0f;
+    snapshot.wait_max = wait_histogram.max_ms / 1000.0f;
+    pthread_mutex_unlock(&wait_histogram_lock);
+
+    telemetry_write_begin(telemetry_segment);
+    memcpy(&telemetry_segment->data, &snapshot, sizeof(snapshot));
+    telemetry_write_end(telemetry_segment);
+}
+
+void shutdown_telemetry(int arrived) {
+    if (telemetry_segment == NULL) return;
+
+    next_telemetry_time = 0;
+    publish_telemetry(arrived);
+    munmap(telemetry_segment, sizeof(TelemetrySegment));
+    shm_unlink(telemetry_name);
+    telemetry_segment = NULL;
+}
@@ -0,0 +1,153 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "telemetry_shm.h"
+
+// Live view of a running simulator's telemetry segment (CHECKOUT_TELEMETRY=1).
+// Build with: gcc telemetry_reader.c -o telemetry_reader (add -lrt on older glibc)
+
+const char* lane_status_names[] = {"open", "closing", "closed"};
+
+const TelemetrySegment* open_segment(const char* name) {
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0) return NULL;
+    void* map = mmap(NULL, sizeof(TelemetrySegment), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return NULL;
+
+    const TelemetrySegment* segment = (const TelemetrySegment*)map;
+    if (__atomic_load_n(&segment->magic, __ATOMIC_ACQUIRE) != TELEMETRY_MAGIC ||
+        segment->version != TELEMETRY_VERSION) {
+        munmap(map, sizeof(TelemetrySegment));
+        return NULL;
+    }
+    return segment;
+}
+
+void print_top(const TelemetrySnapshot* s) {
+    printf("\033[H\033[2J");
+    printf("checkout simulator pid %d  seed %llu  %s  up %.0f s\n", s->pid, (unsigned long long)s->seed,
+           s->running ? "running" : "finished", s->uptime_seconds);
+    printf("customers: %lld arrived, %lld served of %lld\n", (long long)s->arrived, (long long)s->served,
+           (long long)s->total_customers);
+    printf("wait: mean %.1f s  p50 %.1f s  p95 %.1f s  p99 %.1f s  max %.1f s\n\n", s->wait_mean, s->wait_p50,
+           s->wait_p95, s->wait_p99, s->wait_max);
+    printf("%-10s %-8s %6s %8s %8s %8s %7s %8s\n", "lane", "status", "queue", "serving", "served", "items",
+           "util", "s/item");
+
+    int cashiers = 0;
+    int kiosks = 0;
+    for (int i = 0; i < s->lane_count && i < TELEMETRY_MAX_LANES; i++) {
+        const TelemetryLane* lane = &s->lanes[i];
+        char name[24];
+        if (lane->kind == TELEMETRY_LANE_CASHIER) snprintf(name, sizeof(name), "cashier %d", ++cashiers);
+        else snprintf(name, sizeof(name), "kiosk %d", ++kiosks);
+        const char* status = lane->status >= 0 && lane->status <= 2 ? lane_status_names[lane->status] : "?";
+        printf("%-10s %-8s %6d %8s %8lld %8lld %6.0f%% %8.2f\n", name, status, lane->queue_length,
+               lane->serving ? "yes" : "no", (long long)lane->served, (long long)lane->items,
+               lane->utilization * 100.0f, lane->seconds_per_item);
+    }
+    fflush(stdout);
+}
+
+// Written to a temporary file and renamed, so a textfile collector never sees
+// a half-written scrape.
+int write_prometheus(const TelemetrySnapshot* s, const char* path) {
+    char temp[1024];
+    snprintf(temp, sizeof(temp), "%s.tmp", path);
+    FILE* f = fopen(temp, "w");
+    if (f == NULL) {
+        perror(temp);
+        return 0;
+    }
+
+    fprintf(f, "# TYPE checkout_running gauge\ncheckout_running %d\n", s->running);
+    fprintf(f, "# TYPE checkout_uptime_seconds gauge\ncheckout_uptime_seconds %.3f\n", s->uptime_seconds);
+    fprintf(f, "# TYPE checkout_customers_arrived_total counter\ncheckout_customers_arrived_total %lld\n",
+            (long long)s->arrived);
+    fprintf(f, "# TYPE checkout_customers_served_total counter\ncheckout_customers_served_total %lld\n",
+            (long long)s->served);
+    fprintf(f, "# TYPE checkout_wait_seconds summary\n");
+    fprintf(f, "checkout_wait_seconds{quantile=\"0.5\"} %.3f\n", s->wait_p50);
+    fprintf(f, "checkout_wait_seconds{quantile=\"0.95\"} %.3f\n", s->wait_p95);
+    fprintf(f, "checkout_wait_seconds{quantile=\"0.99\"} %.3f\n", s->wait_p99);
+    fprintf(f, "# TYPE checkout_wait_max_seconds gauge\ncheckout_wait_max_seconds %.3f\n", s->wait_max);
+
+    const char* metrics[] = {"queue_length", "serving", "served_total", "items_total", "utilization"};
+    const char* types[] = {"gauge", "gauge", "counter", "counter", "gauge"};
+    for (int m = 0; m < 5; m++) {
+        fprintf(f, "# TYPE checkout_lane_%s %s\n", metrics[m], types[m]);
+        int cashiers = 0;
+        int kiosks = 0;
+        for (int i = 0; i < s->lane_count && i < TELEMETRY_MAX_LANES; i++) {
+            const TelemetryLane* lane = &s->lanes[i];
+            const char* kind = lane->kind == TELEMETRY_LANE_CASHIER ? "cashier" : "kiosk";
+            int index = lane->kind == TELEMETRY_LANE_CASHIER ? ++cashiers : ++kiosks;
+            double value = m == 0 ? lane->queue_length : m == 1 ? lane->serving : m == 2 ? (double)lane->served
+                         : m == 3 ? (double)lane->items : lane->utilization;
+            fprintf(f, "checkout_lane_%s{kind=\"%s\",lane=\"%d\"} %g\n", metrics[m], kind, index, value);
+        }
+    }
+
+    if (fclose(f) != 0 || rename(temp, path) != 0) {
+        perror(path);
+        return 0;
+    }
+    return 1;
+}
+
+int main(int argc, char* argv[]) {
+    const char* name = "/checkout_telemetry";
+    const char* prometheus_path = NULL;
+    int interval_ms = 500;
+    int once = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--name") == 0 && i + 1 < argc) name = argv[++i];
+        else if (strcmp(argv[i], "--interval") == 0 && i + 1 < argc) interval_ms = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--prometheus") == 0 && i + 1 < argc) prometheus_path = argv[++i];
+        else if (strcmp(argv[i], "--once") == 0) once = 1;
+        else {
+            printf("Usage: %s [--name /checkout_telemetry] [--interval ms] [--prometheus file] [--once]\n", argv[0]);
+            return strcmp(argv[i], "--help") == 0 ? 0 : 1;
+        }
+    }
+    if (interval_ms < 10) interval_ms = 10;
+
+    const TelemetrySegment* segment = NULL;
+    TelemetrySnapshot* snapshot = (TelemetrySnapshot*)malloc(sizeof(TelemetrySnapshot));
+    while (1) {
+        if (segment == NULL) {
+            segment = open_segment(name);
+            if (segment == NULL) {
+                if (once) {
+                    printf("No telemetry segment %s (is the simulator running with CHECKOUT_TELEMETRY=1?)\n", name);
+                    free(snapshot);
+                    return 1;
+                }
+                usleep(interval_ms * 1000);
+                continue;
+            }
+        }
+
+        if (telemetry_read(segment, snapshot, 1000)) {
+            if (prometheus_path != NULL) write_prometheus(snapshot, prometheus_path);
+            else print_top(snapshot);
+
+            if (!snapshot->running && snapshot->uptime_seconds > 0) {
+                munmap((void*)segment, sizeof(TelemetrySegment));
+                segment = NULL;
+                if (once || prometheus_path == NULL) break;
+            }
+        }
+        if (once) break;
+        usleep(interval_ms * 1000);
+    }
+
+    free(snapshot);
+    return 0;
+}
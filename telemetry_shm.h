@@ -0,0 +1,75 @@
+#ifndef TELEMETRY_SHM_H
+#define TELEMETRY_SHM_H
+
+#include <stdint.h>
+#include <string.h>
+
+// Layout of the shared telemetry segment. This header is shared by the
+// simulator and telemetry_reader.c, so it depends on nothing else in the tree.
+
+#define TELEMETRY_MAGIC 0x43484b54u
+#define TELEMETRY_VERSION 1
+#define TELEMETRY_MAX_LANES 256
+#define TELEMETRY_LANE_CASHIER 1
+#define TELEMETRY_LANE_KIOSK 2
+
+typedef struct {
+    int32_t kind;
+    int32_t status;
+    int32_t queue_length;
+    int32_t serving;
+    int64_t served;
+    int64_t items;
+    float utilization;
+    float seconds_per_item;
+} TelemetryLane;
+
+typedef struct {
+    int32_t running;
+    int32_t pid;
+    uint64_t seed;
+    double uptime_seconds;
+    int64_t arrived;
+    int64_t served;
+    int64_t total_customers;
+    float wait_mean;
+    float wait_p50;
+    float wait_p95;
+    float wait_p99;
+    float wait_max;
+    int32_t lane_count;
+    TelemetryLane lanes[TELEMETRY_MAX_LANES];
+} TelemetrySnapshot;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t sequence;
+    uint32_t padding;
+    TelemetrySnapshot data;
+} TelemetrySegment;
+
+// Single writer. The sequence is odd while an update is in progress.
+static inline void telemetry_write_begin(TelemetrySegment* segment) {
+    __atomic_store_n(&segment->sequence, segment->sequence + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static inline void telemetry_write_end(TelemetrySegment* segment) {
+    __atomic_store_n(&segment->sequence, segment->sequence + 1, __ATOMIC_RELEASE);
+}
+
+// Readers never block the writer; they retry until they copy a consistent
+// snapshot.
+static inline int telemetry_read(const TelemetrySegment* segment, TelemetrySnapshot* out, int max_tries) {
+    for (int attempt = 0; attempt < max_tries; attempt++) {
+        uint32_t before = __atomic_load_n(&segment->sequence, __ATOMIC_ACQUIRE);
+        if (before & 1) continue;
+        memcpy(out, (const void*)&segment->data, sizeof(TelemetrySnapshot));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&segment->sequence, __ATOMIC_RELAXED) == before) return 1;
+    }
+    return 0;
+}
+
+#endif
@@ -0,0 +1,42 @@
+#include "structs.h"
+#include <pthread.h>
+
+// Victims are lanes of the thief's own kind whose every customer the thief
+// may serve.
+Customer* steal_for_lane(Lane* thief) {
+    int max_size = steal_min_queue - 1;
+    Lane* victim = NULL;
+
+    for (int i = 0; i < total_lane_count(); i++) {
+        Lane* lane = &all_lanes[i];
+        if (lane == thief || lane->kind != thief->kind) continue;
+        if (!limit_covers(thief->max_items, lane->max_items)) continue;
+        pthread_mutex_lock(&lane->queue->lock);
+        if (lane->queue->size > max_size) {
+            max_size = lane->queue->size;
+            victim = lane;
+        }
+        pthread_mutex_unlock(&lane->queue->lock);
+    }
+
+    if (victim == NULL) return NULL;
+    return steal_tail(victim->queue, steal_min_queue);
+}
+
+Customer* lane_next_customer(Lane* lane) {
+    if (lane->line != NULL) return shared_line_next(lane->line, lane->queue, &lane->status);
+    if (!work_stealing_enabled) return dequeue(lane->queue);
+
+    while (simulation_running && !all_customers_served) {
+        Customer* c = dequeue_timeout(lane->queue, steal_poll_ms);
+        if (c != NULL) return c;
+        if (lane->status != LANE_OPEN || clock_is_paused()) continue;
+
+        c = steal_for_lane(lane);
+        if (c != NULL) {
+            lane->customers_stolen++;
+            return c;
+        }
+    }
+    return NULL;
+}